@@ -6,12 +6,6 @@
 #include "LS7366R_Single.h"
 #include <SPI.h>
 
-// SPI Settings for LS7366R
-// According to datasheet: max 10MHz, but 500kHz is more reliable
-#define LS7366R_SPI_SPEED    500000  // 500 kHz
-#define LS7366R_SPI_MODE     SPI_MODE0
-#define LS7366R_SPI_BITORDER MSBFIRST
-
 // Timing delays (microseconds)
 #define LS7366R_CS_SETUP     5   // CS setup time
 #define LS7366R_CS_HOLD      5   // CS hold time
@@ -23,7 +17,11 @@
 // ============================================================================
 
 LS7366R_Single::LS7366R_Single(uint8_t csPin, uint8_t mdr0_config, uint8_t mdr1_config)
-    : csPin(csPin), countValue(0), mdr0Config(mdr0_config), mdr1Config(mdr1_config)
+    : csPin(csPin), countValue(0), syncMicros(0), mdr0Config(mdr0_config), mdr1Config(mdr1_config),
+      externalTransaction(false)
+#ifdef BUS_TRACE
+      , trace(0), traceRecord(0)
+#endif
 {
     // Pin setup will be done in begin()
 }
@@ -56,11 +54,11 @@ void LS7366R_Single::reset()
     spiBegin();
     
     // Clear counter register
-    digitalWrite(csPin, LOW);
+    select();
     delayMicroseconds(LS7366R_CS_SETUP);
-    SPI.transfer(LS7366R_CMD_CLEAR | LS7366R_REG_CNTR);
+    transfer(LS7366R_CMD_CLEAR | LS7366R_REG_CNTR);
     delayMicroseconds(LS7366R_CS_HOLD);
-    digitalWrite(csPin, HIGH);
+    deselect();
     
     spiEnd();
     
@@ -72,32 +70,36 @@ void LS7366R_Single::reset()
 
 void LS7366R_Single::sync()
 {
+#ifdef OP_PROFILE
+    op_profile_scope profile(OP_PROFILE_LS7366R_SYNC);
+#endif
     spiBegin();
     
     // Step 1: Load counter value into OTR (Output Transfer Register)
-    digitalWrite(csPin, LOW);
+    select();
     delayMicroseconds(LS7366R_CS_SETUP);
-    SPI.transfer(LS7366R_CMD_LOAD | LS7366R_REG_OTR);
+    transfer(LS7366R_CMD_LOAD | LS7366R_REG_OTR);
+    syncMicros = micros();
     delayMicroseconds(LS7366R_CS_HOLD);
-    digitalWrite(csPin, HIGH);
+    deselect();
     
     // Wait for OTR to load (datasheet requirement)
     delayMicroseconds(LS7366R_OTR_LOAD);
     
     // Step 2: Read 32-bit value from OTR register
-    digitalWrite(csPin, LOW);
+    select();
     delayMicroseconds(LS7366R_CS_SETUP);
-    SPI.transfer(LS7366R_CMD_READ | LS7366R_REG_OTR);
+    transfer(LS7366R_CMD_READ | LS7366R_REG_OTR);
     
     // Read 4 bytes (MSB first)
     uint32_t count = 0;
-    count = ((uint32_t)SPI.transfer(0x00)) << 24;
-    count |= ((uint32_t)SPI.transfer(0x00)) << 16;
-    count |= ((uint32_t)SPI.transfer(0x00)) << 8;
-    count |= (uint32_t)SPI.transfer(0x00);
+    count = ((uint32_t)transfer(0x00)) << 24;
+    count |= ((uint32_t)transfer(0x00)) << 16;
+    count |= ((uint32_t)transfer(0x00)) << 8;
+    count |= (uint32_t)transfer(0x00);
     
     delayMicroseconds(LS7366R_CS_HOLD);
-    digitalWrite(csPin, HIGH);
+    deselect();
     
     spiEnd();
     
@@ -124,6 +126,22 @@ void LS7366R_Single::reconfigure(uint8_t mdr0_config, uint8_t mdr1_config)
     spiEnd();
 }
 
+void LS7366R_Single::setMDR0(uint8_t mdr0_config)
+{
+    spiBegin();
+    writeRegister(LS7366R_REG_MDR0, mdr0_config);
+    mdr0Config = mdr0_config;
+    spiEnd();
+}
+
+void LS7366R_Single::setMDR1(uint8_t mdr1_config)
+{
+    spiBegin();
+    writeRegister(LS7366R_REG_MDR1, mdr1_config);
+    mdr1Config = mdr1_config;
+    spiEnd();
+}
+
 uint8_t LS7366R_Single::readStatus()
 {
     spiBegin();
@@ -169,11 +187,11 @@ void LS7366R_Single::clearStatus()
     spiBegin();
     
     // Clear status register (this clears phase errors and flags)
-    digitalWrite(csPin, LOW);
+    select();
     delayMicroseconds(LS7366R_CS_SETUP);
-    SPI.transfer(LS7366R_CMD_CLEAR | LS7366R_REG_STR);
+    transfer(LS7366R_CMD_CLEAR | LS7366R_REG_STR);
     delayMicroseconds(LS7366R_CS_HOLD);
-    digitalWrite(csPin, HIGH);
+    deselect();
     
     spiEnd();
     
@@ -186,44 +204,86 @@ void LS7366R_Single::clearStatus()
 
 void LS7366R_Single::writeRegister(uint8_t reg, uint8_t value)
 {
-    digitalWrite(csPin, LOW);
+#ifdef OP_PROFILE
+    op_profile_scope profile(OP_PROFILE_LS7366R_WRITE_REGISTER);
+#endif
+    select();
     delayMicroseconds(LS7366R_CS_SETUP);
     
     // Send write command + register address
-    SPI.transfer(LS7366R_CMD_WRITE | reg);
+    transfer(LS7366R_CMD_WRITE | reg);
     delayMicroseconds(LS7366R_CMD_DELAY);
     
     // Send data
-    SPI.transfer(value);
+    transfer(value);
     delayMicroseconds(LS7366R_CS_HOLD);
     
-    digitalWrite(csPin, HIGH);
+    deselect();
 }
 
 uint8_t LS7366R_Single::readRegister(uint8_t reg)
 {
-    digitalWrite(csPin, LOW);
+#ifdef OP_PROFILE
+    op_profile_scope profile(OP_PROFILE_LS7366R_READ_REGISTER);
+#endif
+    select();
     delayMicroseconds(LS7366R_CS_SETUP);
     
     // Send read command + register address
-    SPI.transfer(LS7366R_CMD_READ | reg);
+    transfer(LS7366R_CMD_READ | reg);
     delayMicroseconds(LS7366R_CMD_DELAY);
     
     // Read data
-    uint8_t value = SPI.transfer(0x00);
+    uint8_t value = transfer(0x00);
     delayMicroseconds(LS7366R_CS_HOLD);
     
-    digitalWrite(csPin, HIGH);
+    deselect();
     
     return value;
 }
 
+void LS7366R_Single::select()
+{
+    digitalWrite(csPin, LOW);
+#ifdef BUS_TRACE
+    traceRecord = trace ? trace->beginFrame(csPin, BUS_TRACE_LS7366R, micros()) : 0;
+#endif
+}
+
+void LS7366R_Single::deselect()
+{
+    digitalWrite(csPin, HIGH);
+#ifdef BUS_TRACE
+    if (traceRecord) {
+        bus_trace::endFrame(traceRecord, micros());
+        traceRecord = 0;
+    }
+#endif
+}
+
+uint8_t LS7366R_Single::transfer(uint8_t out)
+{
+    uint8_t in = SPI.transfer(out);
+#ifdef BUS_TRACE
+    if (traceRecord) {
+        bus_trace::put(traceRecord, out, in);
+    }
+#endif
+    return in;
+}
+
 void LS7366R_Single::spiBegin()
 {
+    if (externalTransaction) {
+        return;
+    }
     SPI.beginTransaction(SPISettings(LS7366R_SPI_SPEED, LS7366R_SPI_BITORDER, LS7366R_SPI_MODE));
 }
 
 void LS7366R_Single::spiEnd()
 {
+    if (externalTransaction) {
+        return;
+    }
     SPI.endTransaction();
 }
@@ -21,6 +21,12 @@
 #define LS7366R_SINGLE_H
 
 #include <Arduino.h>
+#ifdef BUS_TRACE
+#include "bus_trace.h"
+#endif
+#ifdef OP_PROFILE
+#include "op_profile.h"
+#endif
 
 // ============================================================================
 // LS7366R Command Definitions
@@ -90,6 +96,15 @@
 #define LS7366R_MDR1_FLAG_BW         0x40  ///< Flag on BW (underflow)
 #define LS7366R_MDR1_FLAG_CY         0x80  ///< Flag on CY (overflow)
 
+// ============================================================================
+// SPI Settings
+// ============================================================================
+
+/** According to datasheet: max 10MHz, but 500kHz is more reliable */
+#define LS7366R_SPI_SPEED    500000  ///< 500 kHz
+#define LS7366R_SPI_MODE     SPI_MODE0
+#define LS7366R_SPI_BITORDER MSBFIRST
+
 // ============================================================================
 // Default Configuration
 // ============================================================================
@@ -146,12 +161,32 @@ public:
      */
     int32_t getCount() const { return countValue; }
     
+    /**
+     * @brief Get the time at which the last sync() latched the counter
+     * @return micros() at the OTR load of the last sync()
+     * @note Pair with getCount() for timestamped samples
+     */
+    uint32_t getSyncMicros() const { return syncMicros; }
+    
     /**
      * @brief Reconfigure MDR0 and MDR1 registers
      * @param mdr0_config New MDR0 configuration
      * @param mdr1_config New MDR1 configuration
      */
     void reconfigure(uint8_t mdr0_config, uint8_t mdr1_config);
+
+    /**
+     * @brief Write MDR0 only, without the settle delay of reconfigure()
+     * @param mdr0_config New MDR0 configuration
+     * @note For callers that spread a reconfigure over time slots
+     */
+    void setMDR0(uint8_t mdr0_config);
+
+    /**
+     * @brief Write MDR1 only, without the settle delay of reconfigure()
+     * @param mdr1_config New MDR1 configuration
+     */
+    void setMDR1(uint8_t mdr1_config);
     
     /**
      * @brief Read status register
@@ -180,11 +215,32 @@ public:
      */
     bool isEnabled() const;
 
+    /**
+     * @brief Leave SPI.beginTransaction()/endTransaction() to the caller
+     * @param external true if a bus arbiter opens the transaction (with the
+     *                 LS7366R_SPI_* settings) around each call
+     */
+    void setExternalTransaction(bool external) { externalTransaction = external; }
+
+#ifdef BUS_TRACE
+    /**
+     * @brief Record every CS frame into a bus trace (built with BUS_TRACE)
+     * @param trace Trace, 0 to stop recording this chip
+     */
+    void setTrace(bus_trace *trace) { this->trace = trace; }
+#endif
+
 private:
     uint8_t csPin;           ///< Chip Select pin
     int32_t countValue;      ///< Cached counter value
+    uint32_t syncMicros;     ///< micros() when countValue was latched
     uint8_t mdr0Config;      ///< Current MDR0 configuration
     uint8_t mdr1Config;      ///< Current MDR1 configuration
+    bool externalTransaction; ///< SPI transaction opened by the caller
+#ifdef BUS_TRACE
+    bus_trace *trace;             ///< Frame recorder (optional)
+    bus_trace_record *traceRecord; ///< Frame being recorded
+#endif
     
     /**
      * @brief Write a register
@@ -199,6 +255,13 @@ private:
      * @return Register value
      */
     uint8_t readRegister(uint8_t reg);
+
+    /**
+     * @brief CS low / CS high, one SPI byte (recorded with BUS_TRACE)
+     */
+    void select();
+    void deselect();
+    uint8_t transfer(uint8_t out);
     
     /**
      * @brief SPI transaction helper
@@ -2,29 +2,23 @@
 #define _ABI_ENCODER_H
 
 #include "mbed.h"
+#include "platform_mbed.h"
+#include "abi_encoder_core.h"
 
-class abi_encoder{
+/* mbed wrapper over abi_encoder_core: owns the pins and interrupts */
+class abi_encoder : public abi_encoder_core<mbed_platform>{
     private:
         InterruptIn A;
         InterruptIn B;
-
-        uint8_t A_state, B_state = 0;
-
-        volatile int64_t cnt = 0;
-
-        volatile int before_state = 0;
-        volatile int state = 0;
-
-        uint16_t spr = 4000;
-        float related_distance = 0.0f;
+        InterruptIn *Z = nullptr;
 
         void init_pins();
-        void updateState();
 
         void A_rise();
         void B_rise();
         void A_fall();
         void B_fall();
+        void Z_rise();
 
     public:
         /** Creates abi_encoder object with specific content.
@@ -32,29 +26,14 @@ class abi_encoder{
          *  @param pin_A    Pin of incremental signal A
          *  @param pin_B    Pin of incremental signal B
          *  @param spr      Steps per revolution
+         *  @param pin_Z    Pin of index signal Z (NC if not used)
          */
-        abi_encoder(PinName pin_A, PinName pin_B, uint16_t spr = 4000);
+        abi_encoder(PinName pin_A, PinName pin_B, uint16_t spr = 4000, PinName pin_Z = NC);
 
-        /** Set the Steps per revolution (SPR).
-         *
-         *  @param spr      Steps per revolution
-         */
-        void setSPR(uint16_t spr);
+        ~abi_encoder();
 
-        /* Get the value of Steps per revolution (SPR)*/
-        uint16_t getSPR();
-
-        /** Get the amount of steps per revolution.
-         *
-         *  @return     Get the amount of steps per revolution
-         */
-        int64_t getAmountSPR();
-
-        /** Get the number of related rotation turns
-         *
-         *  @return     Get the number of related rotation turns
-         */
-        float getRelatedTurns();
+        /** Reset the counter to zero */
+        void reset();
 };
 
-#endif
\ No newline at end of file
+#endif
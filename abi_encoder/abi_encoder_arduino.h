@@ -9,42 +9,31 @@
  * 
  * Note: If you have LS7366R hardware counter, you don't need this library.
  * This is for software-based decoding only.
+ *
+ * The decoding itself is in abi_encoder_core.h; this class owns the pins
+ * and interrupts.
  */
 
 #ifndef _ABI_ENCODER_ARDUINO_H
 #define _ABI_ENCODER_ARDUINO_H
 
 #include <Arduino.h>
+#include "platform_arduino.h"
+#include "abi_encoder_core.h"
 
-class abi_encoder_arduino{
+/** Pin value meaning "not connected" */
+#define ABI_ENCODER_NO_PIN  0xFF
+
+class abi_encoder_arduino : public abi_encoder_core<arduino_platform>{
     private:
         uint8_t pin_A;
         uint8_t pin_B;
+        uint8_t pin_Z;
 
-        volatile uint8_t A_state;
-        volatile uint8_t B_state;
-
-        volatile int64_t cnt;
-
-        volatile int before_state;
-        volatile int state;
-
-        uint16_t spr;  // Steps per revolution
-        float related_distance;
-
-        void updateState();
-        
-        // Interrupt handlers (static wrappers)
-        static void A_rise_handler(void* obj);
-        static void B_rise_handler(void* obj);
-        static void A_fall_handler(void* obj);
-        static void B_fall_handler(void* obj);
-        
-        // Instance interrupt handlers
-        void A_rise();
-        void B_rise();
-        void A_fall();
-        void B_fall();
+        // Interrupt handlers (static wrappers, CHANGE on A/B, RISING on Z)
+        static void A_change_handler(void* obj);
+        static void B_change_handler(void* obj);
+        static void Z_rise_handler(void* obj);
 
     public:
         /** Creates abi_encoder object with specific content.
@@ -52,35 +41,12 @@ class abi_encoder_arduino{
          *  @param pin_A    Pin of incremental signal A
          *  @param pin_B    Pin of incremental signal B
          *  @param spr      Steps per revolution (default: 4000)
+         *  @param pin_Z    Pin of index signal Z (default: not connected)
          */
-        abi_encoder_arduino(uint8_t pin_A, uint8_t pin_B, uint16_t spr = 4000);
+        abi_encoder_arduino(uint8_t pin_A, uint8_t pin_B, uint16_t spr = 4000, uint8_t pin_Z = ABI_ENCODER_NO_PIN);
 
         /** Destructor - detach interrupts */
         ~abi_encoder_arduino();
-
-        /** Set the Steps per revolution (SPR).
-         *
-         *  @param spr      Steps per revolution
-         */
-        void setSPR(uint16_t spr);
-
-        /** Get the value of Steps per revolution (SPR)
-         *
-         *  @return     Steps per revolution
-         */
-        uint16_t getSPR();
-
-        /** Get the amount of steps per revolution.
-         *
-         *  @return     Current count value
-         */
-        int64_t getAmountSPR();
-
-        /** Get the number of related rotation turns
-         *
-         *  @return     Number of rotation turns
-         */
-        float getRelatedTurns();
         
         /** Reset the counter to zero */
         void reset();
@@ -0,0 +1,356 @@
+/**
+ * @file abi_encoder_core.h
+ * @brief Portable software quadrature (A/B/Z) decoder core
+ *
+ * Header-only implementation shared by abi_encoder (mbed) and
+ * abi_encoder_arduino, templated on a platform policy (see platform.h)
+ * for timestamps and interrupt masking. The wrappers own the pins and
+ * interrupts and call edge() / indexEdge() from their handlers. edge()
+ * takes both channel levels as read in the handler, not just the one
+ * that interrupted.
+ *
+ * The channel levels are packed as AB = (A << 1) | B and decoded with a
+ * 16-entry transition table:
+ *
+ *   01 -> 00 -> 10 -> 11 -> 01  forward (+)
+ *   01 <- 00 <- 10 <- 11 <- 01  reverse (-)
+ *   00 <-> 11, 01 <-> 10        illegal (both channels changed)
+ *
+ * An illegal transition means an edge was missed between two handlers
+ * (interrupt latency above a quarter period): the direction is unknown,
+ * so the count is not moved and is off by up to two from then on.
+ */
+
+#ifndef _ABI_ENCODER_CORE_H
+#define _ABI_ENCODER_CORE_H
+
+#include <stdint.h>
+#include "abi_index.h"
+#ifdef OP_PROFILE
+#include "op_profile.h"
+#endif
+
+/** Channel numbers for edge() */
+#define ABI_CHANNEL_A   0
+#define ABI_CHANNEL_B   1
+
+template <class P>
+class abi_encoder_core{
+    private:
+        volatile uint8_t ab;                // (A << 1) | B
+        volatile int64_t cnt;
+        volatile uint32_t illegal;          // Transitions with both channels changed
+
+        volatile uint32_t last_edge_us;     // Time of the last counted edge
+        volatile uint32_t edge_period_us;   // Time between the last two edges (0 = unknown)
+        volatile int8_t edge_dir;           // Direction of the last edge (+1 / -1)
+
+        uint16_t spr;                       // Steps per revolution
+
+        abi_index index;                    // Index (Z) events
+
+        // Glitch filter: the last accepted edge and the decoder state before it
+        uint32_t glitch_us;                 // Minimum pulse width (0 = off)
+        volatile uint32_t rejected;         // Edges dropped by the filter
+        uint8_t glitch_channel;             // Channel of the last accepted edge
+        uint32_t glitch_edge_us;            // Time of the last accepted edge
+        struct {
+            int64_t cnt;
+            uint32_t last_edge_us;
+            uint32_t edge_period_us;
+            int8_t edge_dir;
+            uint8_t ab;
+        } glitch_undo;
+
+        static int8_t step(uint8_t from, uint8_t to){
+            // [from << 2 | to]: +1 forward, -1 reverse, 0 no movement or illegal
+            static const int8_t table[16] = {
+                 0, -1,  1,  0,
+                 1,  0,  0, -1,
+                -1,  0,  0,  1,
+                 0,  1, -1,  0
+            };
+            return table[(from << 2) | to];
+        }
+
+        bool acceptEdge(uint8_t channel, uint8_t next, uint32_t now){
+            // Pulse shorter than the interrupt latency: the pin is already back
+            if (next == ab) {
+                rejected++;
+                return false;
+            }
+
+            // In quadrature, two edges in a row on one channel are a reversal.
+            // Within the minimum pulse width that is noise: undo the first edge.
+            if (channel == glitch_channel && (now - glitch_edge_us) < glitch_us) {
+                cnt = glitch_undo.cnt;
+                last_edge_us = glitch_undo.last_edge_us;
+                edge_period_us = glitch_undo.edge_period_us;
+                edge_dir = glitch_undo.edge_dir;
+                ab = glitch_undo.ab;
+
+                glitch_channel = 0xFF;
+                rejected += 2;
+                return false;
+            }
+
+            glitch_undo.cnt = cnt;
+            glitch_undo.last_edge_us = last_edge_us;
+            glitch_undo.edge_period_us = edge_period_us;
+            glitch_undo.edge_dir = edge_dir;
+            glitch_undo.ab = ab;
+            glitch_channel = channel;
+            glitch_edge_us = now;
+            return true;
+        }
+
+    public:
+        /** Creates abi_encoder_core object with specific content.
+         *
+         *  @param spr      Steps per revolution
+         */
+        explicit abi_encoder_core(uint16_t spr = 4000)
+            : ab(0), cnt(0), illegal(0), last_edge_us(0), edge_period_us(0), edge_dir(0),
+              spr(spr), glitch_us(0), rejected(0), glitch_channel(0xFF), glitch_edge_us(0) {
+        }
+
+        /** Set the channel levels without counting (startup / reset)
+         *
+         *  @param a    Level of A
+         *  @param b    Level of B
+         */
+        void setLevels(uint8_t a, uint8_t b){
+            P::lock();
+            ab = (uint8_t)(((a ? 1 : 0) << 1) | (b ? 1 : 0));
+            last_edge_us = P::micros();
+            edge_period_us = 0;
+            edge_dir = 0;
+            glitch_channel = 0xFF;
+            P::unlock();
+        }
+
+        /** Feed one channel edge (call from the A/B interrupts)
+         *
+         *  @param channel  ABI_CHANNEL_A or ABI_CHANNEL_B (the interrupting one)
+         *  @param a        Level of A read in the handler
+         *  @param b        Level of B read in the handler
+         */
+        void edge(uint8_t channel, uint8_t a, uint8_t b){
+#ifdef OP_PROFILE
+            op_profile_scope profile(OP_PROFILE_ABI_EDGE);
+#endif
+            P::lockFromISR();
+            uint8_t next = (uint8_t)(((a ? 1 : 0) << 1) | (b ? 1 : 0));
+            uint32_t now = P::micros();
+
+            if (glitch_us && !acceptEdge(channel, next, now)) {
+                P::unlockFromISR();
+                return;
+            }
+
+            uint8_t prev = ab;
+            ab = next;
+
+            int8_t dir = step(prev, next);
+            if (dir) {
+                cnt += dir;
+                // Period is only meaningful between two edges in the same direction
+                edge_period_us = (dir == edge_dir) ? (now - last_edge_us) : 0;
+                edge_dir = dir;
+                last_edge_us = now;
+            } else if ((prev ^ next) == 0x03) {
+                illegal++;
+            }
+            P::unlockFromISR();
+        }
+
+        /** Feed an index edge (call from the Z rising-edge interrupt) */
+        void indexEdge(){
+#ifdef OP_PROFILE
+            op_profile_scope profile(OP_PROFILE_ABI_INDEX);
+#endif
+            P::lockFromISR();
+            int64_t latched = index.latch(cnt, P::micros(), spr);
+            // Keep a pending glitch undo relative: it must not bring back
+            // the count from before the latch
+            glitch_undo.cnt += latched - cnt;
+            cnt = latched;
+            P::unlockFromISR();
+        }
+
+        /** Set the Steps per revolution (SPR).
+         *
+         *  @param spr      Steps per revolution
+         */
+        void setSPR(uint16_t spr){
+            this->spr = spr;
+        }
+
+        /** Get the value of Steps per revolution (SPR)
+         *
+         *  @return     Steps per revolution
+         */
+        uint16_t getSPR(){
+            return spr;
+        }
+
+        /** Get the amount of steps per revolution.
+         *
+         *  @return     Current count value
+         */
+        int64_t getAmountSPR(){
+            P::lock();
+            int64_t count = cnt;
+            P::unlock();
+            return count;
+        }
+
+        /** Get the number of related rotation turns
+         *
+         *  @return     Number of rotation turns
+         */
+        float getRelatedTurns(){
+            return (float)((double)getAmountSPR() / spr);
+        }
+
+        /** Get the count together with the time of the edge that produced it
+         *
+         *  Both values are read under P::lock() so they belong to
+         *  the same edge.
+         *
+         *  @param count    Current count value
+         *  @param edge_us  Timestamp of the last counted edge
+         */
+        void getEdgeSnapshot(int64_t *count, uint32_t *edge_us){
+            P::lock();
+            *count = cnt;
+            *edge_us = last_edge_us;
+            P::unlock();
+        }
+
+        /** Get the position between edges
+         *
+         *  Extrapolates from the last edge at the current edge period. The
+         *  fraction is clamped below one count, so the result never crosses
+         *  the next edge; after a reversal or a reset it is the plain count.
+         *
+         *  @param now_us   Current time
+         *  @return         Position (counts, Q16)
+         */
+        int64_t getInterpolatedPosition(uint32_t now_us){
+            P::lock();
+            int64_t count = cnt;
+            uint32_t edge_us = last_edge_us;
+            uint32_t period = edge_period_us;
+            int8_t dir = edge_dir;
+            P::unlock();
+
+            int64_t pos = count * 65536;
+            if (period == 0) {
+                return pos;
+            }
+
+            // Fraction of the current edge period already elapsed, kept below one count
+            uint32_t elapsed = now_us - edge_us;
+            uint32_t frac = 0xFFFF;
+            if (elapsed < period) {
+                frac = (uint32_t)(((uint64_t)elapsed << 16) / period);
+            }
+
+            return pos + (dir > 0 ? (int64_t)frac : -(int64_t)frac);
+        }
+
+        /** Get the number of illegal transitions (both channels changed)
+         *
+         *  Each one is an edge the handlers missed; the count may be off.
+         *
+         *  @return     Illegal transition count
+         */
+        uint32_t getIllegalTransitions(){
+            return illegal;
+        }
+
+        /** Get the number of index events lost to a full buffer
+         *
+         *  readIndex() was not called often enough; the count is still
+         *  latched (and zeroed or checked) at every index edge.
+         *
+         *  @return     Index overflow count
+         */
+        uint32_t getIndexOverflows(){
+            return index.getOverflows();
+        }
+
+        /** Set what happens on an index edge
+         *
+         *  @param mode     ABI_INDEX_LATCH, or ABI_INDEX_ZERO / ABI_INDEX_CHECK flags
+         */
+        void setIndexMode(uint8_t mode){
+            index.setMode(mode);
+        }
+
+        /** Take the oldest latched index event
+         *
+         *  @param ev   Index event (count and time at the index edge)
+         *  @return     false if no event is pending
+         */
+        bool readIndex(abi_index_event *ev){
+            P::lock();
+            bool pending = index.read(ev);
+            P::unlock();
+            return pending;
+        }
+
+        /** Check whether an index edge has been seen
+         *
+         *  @return     true once the encoder has passed the index
+         */
+        bool isIndexed(){
+            return index.isHomed();
+        }
+
+        /** Get the number of revolutions that failed the spr check
+         *
+         *  @return     Drift error count (ABI_INDEX_CHECK)
+         */
+        uint32_t getIndexDriftErrors(){
+            return index.getDriftErrors();
+        }
+
+        /** Set the minimum pulse width of the glitch filter
+         *
+         *  An edge that reverses the previous edge on the same channel
+         *  within this time is a glitch: both edges are dropped and the
+         *  count and edge timing return to their state before the pulse.
+         *
+         *  @param min_pulse_us     Minimum pulse width (us), 0 to disable
+         */
+        void setGlitchFilter(uint32_t min_pulse_us){
+            P::lock();
+            glitch_us = min_pulse_us;
+            glitch_channel = 0xFF;
+            P::unlock();
+        }
+
+        /** Get the number of edges dropped by the glitch filter
+         *
+         *  @return     Rejected edge count
+         */
+        uint32_t getRejectedEdges(){
+            return rejected;
+        }
+
+        /** Reset the counter to zero (levels are kept) */
+        void clearCount(){
+            P::lock();
+            index.offset(-cnt);
+            cnt = 0;
+            last_edge_us = P::micros();
+            edge_period_us = 0;
+            edge_dir = 0;
+            glitch_channel = 0xFF;
+            P::unlock();
+        }
+};
+
+#endif
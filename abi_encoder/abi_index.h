@@ -0,0 +1,139 @@
+/**
+ * @file abi_index.h
+ * @brief Index (Z) pulse handling for the software ABI decoders
+ *
+ * Shared by abi_encoder (mbed) and abi_encoder_arduino. The decoder calls
+ * latch() from its Z interrupt; each index edge is stored with its count
+ * and time in a small ring buffer that the main loop drains with read().
+ *
+ * Options (setMode):
+ * - ABI_INDEX_ZERO:  the count is zeroed at every index edge
+ * - ABI_INDEX_CHECK: the count between index edges is checked against a
+ *                    whole number of revolutions (spr); misses are counted
+ *
+ * The ring is single-producer (ISR) / single-consumer (loop). When it is
+ * full, new events are dropped and counted as overflows.
+ */
+
+#ifndef _ABI_INDEX_H
+#define _ABI_INDEX_H
+
+#include <stdint.h>
+
+/** Index events held until read (power of two) */
+#define ABI_INDEX_BUFFER_SIZE   8
+
+/** Index mode flags */
+#define ABI_INDEX_LATCH         0x00  ///< Latch only
+#define ABI_INDEX_ZERO          0x01  ///< Zero the count on index
+#define ABI_INDEX_CHECK         0x02  ///< Check counts per revolution against spr
+
+/** Allowed drift per revolution (the index edge moves by one count with direction) */
+#define ABI_INDEX_TOLERANCE     1
+
+/** One index edge */
+struct abi_index_event{
+    int64_t count;      ///< Count at the index edge (before zeroing)
+    uint32_t time_us;   ///< Time of the index edge
+    int32_t drift;      ///< Counts off a whole revolution since the previous index (0 for the first)
+};
+
+class abi_index{
+    private:
+        abi_index_event events[ABI_INDEX_BUFFER_SIZE];
+        volatile uint8_t head;      // Written by latch()
+        volatile uint8_t tail;      // Written by read()
+
+        volatile uint32_t overflows;
+        volatile uint32_t drift_errors;
+
+        int64_t ref_count;          // Count right after the previous index
+        bool homed;
+        uint8_t mode;
+
+    public:
+        abi_index() : head(0), tail(0), overflows(0), drift_errors(0),
+                      ref_count(0), homed(false), mode(ABI_INDEX_LATCH) {}
+
+        /** Set the index mode
+         *
+         *  @param mode     ABI_INDEX_LATCH, or ABI_INDEX_ZERO / ABI_INDEX_CHECK flags
+         */
+        void setMode(uint8_t mode) { this->mode = mode; }
+
+        /** Get the index mode */
+        uint8_t getMode() const { return mode; }
+
+        /** Latch an index edge (call from the Z interrupt)
+         *
+         *  @param count    Count at the index edge
+         *  @param time_us  Time of the index edge
+         *  @param spr      Steps per revolution
+         *  @return         Count to continue from (0 with ABI_INDEX_ZERO)
+         */
+        int64_t latch(int64_t count, uint32_t time_us, uint16_t spr){
+            int32_t drift = 0;
+
+            if (homed && spr) {
+                // Distance from the nearest whole revolution
+                int32_t rem = (int32_t)((count - ref_count) % spr);
+                if (rem > spr / 2) rem -= spr;
+                else if (rem < -(spr / 2)) rem += spr;
+                drift = rem;
+
+                if ((mode & ABI_INDEX_CHECK) &&
+                    (drift > ABI_INDEX_TOLERANCE || drift < -ABI_INDEX_TOLERANCE)) {
+                    drift_errors++;
+                }
+            }
+
+            uint8_t next = (head + 1) & (ABI_INDEX_BUFFER_SIZE - 1);
+            if (next == tail) {
+                overflows++;
+            } else {
+                events[head].count = count;
+                events[head].time_us = time_us;
+                events[head].drift = drift;
+                head = next;
+            }
+
+            if (mode & ABI_INDEX_ZERO) {
+                count = 0;
+            }
+            ref_count = count;
+            homed = true;
+
+            return count;
+        }
+
+        /** Take the oldest index event
+         *
+         *  @param ev   Index event
+         *  @return     false if no event is pending
+         */
+        bool read(abi_index_event *ev){
+            if (tail == head) {
+                return false;
+            }
+            *ev = events[tail];
+            tail = (tail + 1) & (ABI_INDEX_BUFFER_SIZE - 1);
+            return true;
+        }
+
+        /** Keep the drift reference when the count is moved outside an index edge
+         *
+         *  @param delta    Amount added to the count
+         */
+        void offset(int64_t delta) { ref_count += delta; }
+
+        /** true once an index edge has been seen */
+        bool isHomed() const { return homed; }
+
+        /** Revolutions that failed the ABI_INDEX_CHECK test */
+        uint32_t getDriftErrors() const { return drift_errors; }
+
+        /** Index events dropped because the buffer was full */
+        uint32_t getOverflows() const { return overflows; }
+};
+
+#endif
@@ -0,0 +1,53 @@
+/**
+ * @file as5047p_angle.h
+ * @brief Integer/fixed-point conversions for the 14-bit AS5047P angle
+ *
+ * All helpers are constexpr and take the raw ANGLECOM value (0..16383):
+ *
+ *   as5047p_raw_to_q16()        turn fraction, Q16 (0..65532), exact
+ *   as5047p_raw_to_centideg()   0.01 deg (0..35998), rounded to nearest
+ *   as5047p_raw_to_mrad()       milliradians (0..6283), +/-0.5 mrad
+ *   as5047p_raw_to_deg()        float deg, one multiply (optional)
+ *
+ * The integer forms need no FPU and no division; the float form is only
+ * compiled in where it is used.
+ */
+
+#ifndef _AS5047P_ANGLE_H
+#define _AS5047P_ANGLE_H
+
+#include <stdint.h>
+
+#define AS5047P_ANGLE_BITS      14
+#define AS5047P_ANGLE_MASK      0x3FFF
+#define AS5047P_ANGLE_HALF      0x2000
+
+// 2*pi*1000 / 16384 in Q16
+#define AS5047P_MRAD_PER_LSB_Q16    25133
+
+/** Raw angle -> fraction of a turn (Q16) */
+constexpr uint16_t as5047p_raw_to_q16(uint16_t raw){
+    return (uint16_t)((raw & AS5047P_ANGLE_MASK) << (16 - AS5047P_ANGLE_BITS));
+}
+
+/** Q16 turn fraction -> raw angle */
+constexpr uint16_t as5047p_q16_to_raw(uint16_t q16){
+    return (uint16_t)(q16 >> (16 - AS5047P_ANGLE_BITS));
+}
+
+/** Raw angle -> centidegrees (36000 / 16384 = 1125 / 512), rounded to nearest */
+constexpr uint16_t as5047p_raw_to_centideg(uint16_t raw){
+    return (uint16_t)(((uint32_t)(raw & AS5047P_ANGLE_MASK) * 1125 + 256) >> 9);
+}
+
+/** Raw angle -> milliradians */
+constexpr uint16_t as5047p_raw_to_mrad(uint16_t raw){
+    return (uint16_t)(((uint32_t)(raw & AS5047P_ANGLE_MASK) * AS5047P_MRAD_PER_LSB_Q16 + 0x8000) >> 16);
+}
+
+/** Raw angle -> degrees (float convenience) */
+constexpr float as5047p_raw_to_deg(uint16_t raw){
+    return (float)(raw & AS5047P_ANGLE_MASK) * (360.0f / 16384.0f);
+}
+
+#endif
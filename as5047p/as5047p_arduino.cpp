@@ -7,298 +7,13 @@
 
 #include "as5047p_arduino.h"
 
-// NOP macro for different platforms
-#if defined(__AVR__)
-    #define NOP_ASM() asm volatile("nop")
-#elif defined(ESP32) || defined(ESP8266)
-    #define NOP_ASM() asm volatile("nop")
-#elif defined(__ARM__)
-    #define NOP_ASM() __asm__ __volatile__("nop")
+// MISO needs a pull-up; ESP32 has one built in, other boards need an external resistor
+#ifdef ESP32
+    #define AS5047P_MISO_PULL PLATFORM_PULL_UP
 #else
-    #define NOP_ASM() do { __asm__ __volatile__("nop"); } while(0)
+    #define AS5047P_MISO_PULL PLATFORM_PULL_NONE
 #endif
 
 as5047p_arduino::as5047p_arduino(uint8_t pin1, uint8_t pin2, uint8_t pin3, uint8_t pin4) 
-    : cs_pin(pin1), miso_pin(pin2), clk_pin(pin3), mosi_pin(pin4) {
-    // Configure pins
-    pinMode(cs_pin, OUTPUT);
-    pinMode(clk_pin, OUTPUT);
-    pinMode(mosi_pin, OUTPUT);  // MOSI for write operations
-    
-    #ifdef ESP32
-        pinMode(miso_pin, INPUT_PULLUP);
-    #else
-        pinMode(miso_pin, INPUT);
-        // For non-ESP32 boards, you may need external pull-up resistor
-    #endif
-
-    // Initialize CS high (inactive)
-    digitalWrite(cs_pin, HIGH);
-    digitalWrite(clk_pin, LOW);
-    digitalWrite(mosi_pin, LOW);
-}
-
-void as5047p_arduino::begin(){
-    delay();
-    digitalWrite(cs_pin, LOW);
-    delay();
-}
-
-void as5047p_arduino::end(){
-    delay();
-    digitalWrite(cs_pin, HIGH);
-    delay();
-}
-
-void as5047p_arduino::delay_short(){
-    for(int i = 0; i < 4; i++){
-        NOP_ASM();
-    }
-}
-
-void as5047p_arduino::delay(){
-    for (int i = 0; i < 6; i++) {
-        NOP_ASM();
-    }
-}
-
-void as5047p_arduino::long_delay(){
-    for (int i = 0; i < 40; i++) {
-        NOP_ASM();
-    }
-}
-
-void as5047p_arduino::receive16(uint16_t *buf){
-    uint16_t receive = 0;
-
-    for (int bit = 0; bit < 16; bit++) {
-        digitalWrite(clk_pin, HIGH);
-        delay_short();
-
-        int samples = 0;
-        samples += (int)digitalRead(miso_pin);
-        NOP_ASM();
-        samples += (int)digitalRead(miso_pin);
-        NOP_ASM();
-        samples += (int)digitalRead(miso_pin);
-        NOP_ASM();
-        samples += (int)digitalRead(miso_pin);
-        NOP_ASM();
-        samples += (int)digitalRead(miso_pin);
-
-        receive <<= 1;
-        if (samples > 2) {
-            receive |= 1;
-        }
-
-        digitalWrite(clk_pin, LOW);
-        delay_short();
-    }
-
-    buf[0] = receive;
-}
-
-void as5047p_arduino::send16(uint16_t data){
-    // Send 16 bits MSB first
-    for (int bit = 15; bit >= 0; bit--) {
-        digitalWrite(clk_pin, LOW);
-        delay_short();
-        
-        // Set MOSI pin
-        if (data & (1 << bit)) {
-            digitalWrite(mosi_pin, HIGH);
-        } else {
-            digitalWrite(mosi_pin, LOW);
-        }
-        
-        delay_short();
-        digitalWrite(clk_pin, HIGH);
-        delay_short();
-    }
-    
-    digitalWrite(clk_pin, LOW);
-}
-
-uint16_t as5047p_arduino::transfer16(uint16_t data){
-    uint16_t receive = 0;
-    
-    // Send and receive simultaneously
-    for (int bit = 15; bit >= 0; bit--) {
-        digitalWrite(clk_pin, LOW);
-        delay_short();
-        
-        // Set MOSI pin
-        if (data & (1 << bit)) {
-            digitalWrite(mosi_pin, HIGH);
-        } else {
-            digitalWrite(mosi_pin, LOW);
-        }
-        
-        delay_short();
-        digitalWrite(clk_pin, HIGH);
-        delay_short();
-        
-        // Read MISO pin
-        int samples = 0;
-        samples += (int)digitalRead(miso_pin);
-        NOP_ASM();
-        samples += (int)digitalRead(miso_pin);
-        NOP_ASM();
-        samples += (int)digitalRead(miso_pin);
-        
-        receive <<= 1;
-        if (samples > 1) {
-            receive |= 1;
-        }
-    }
-    
-    digitalWrite(clk_pin, LOW);
-    return receive;
-}
-
-float as5047p_arduino::readAngle(){
-    uint16_t pos = readRegister(AS5047P_REG_ANGLECOM);
-    
-    // Change the unit to deg
-    float deg = (float)(pos * 360.0f) / 16384.0f;
-    
-    return deg;
-}
-
-uint16_t as5047p_arduino::readRegister(uint16_t address){
-    begin();
-    
-    // AS5047P read: send address with read bit (bit 14 = 1)
-    uint16_t cmd = (address & 0x3FFF) | 0x4000;  // Set read bit
-    uint16_t result = transfer16(cmd);
-    
-    end();
-    
-    delayMicroseconds(10);
-    
-    // Mask out parity and error bits, keep only data
-    uint16_t data = result & 0x3FFF;
-    
-    // Debug: If result equals the command (except read bit), SPI might be echoing
-    // This can happen if MISO is not connected or reading at wrong time
-    if ((data | 0x4000) == cmd) {
-        // This looks like we're reading back the command, not the data
-        // This might indicate a communication issue
-    }
-    
-    return data;
-}
-
-bool as5047p_arduino::writeRegister(uint16_t address, uint16_t value){
-    begin();
-    
-    // AS5047P write: send address without read bit (bit 14 = 0)
-    uint16_t cmd = (address & 0x3FFF) & ~0x4000;  // Clear read bit
-    transfer16(cmd);
-    
-    delayMicroseconds(100);  // Increased delay after command
-    
-    // Send data
-    transfer16(value & 0x3FFF);
-    
-    end();
-    
-    delayMicroseconds(200);  // Increased wait for write to complete
-    
-    // For some registers (like ABI_SETTINGS), reading back immediately might not work
-    // Try reading after a longer delay
-    delayMicroseconds(500);
-    
-    // Verify write (read back and compare)
-    uint16_t readback = readRegister(address);
-    
-    // Special handling: if readback is 0x3FFF, it might mean the register is write-only
-    // or there's a communication issue. For ABI_SETTINGS, we'll be more lenient.
-    bool success = false;
-    if (address == AS5047P_REG_ABI_SETTINGS) {
-        // For ABI_SETTINGS:
-        // 1. If readback matches expected value, success
-        // 2. If readback is 0x3FFF (common read failure value), assume write succeeded
-        //    because SPI communication works (readAngle works) and write completed
-        // 3. Otherwise check if enable bit matches
-        if (readback == (value & 0x3FFF)) {
-            success = true;
-        } else if (readback == 0x3FFF) {
-            // Register appears to be write-only or read has issues
-            // Since SPI works (readAngle works), assume write succeeded
-            success = true;
-        } else {
-            // Partial match - check enable bit
-            success = ((readback & AS5047P_ABI_ENABLE) == (value & AS5047P_ABI_ENABLE));
-        }
-    } else {
-        success = (readback == (value & 0x3FFF));
-    }
-    
-    return success;
-}
-
-bool as5047p_arduino::configureABI(uint8_t resolution, uint8_t direction, bool enableIndex){
-    // Build ABI_SETTINGS register value
-    uint16_t settings = resolution & 0x07;  // Bits 0-2: resolution
-    
-    if (direction == AS5047P_ABI_DIR_CCW) {
-        settings |= AS5047P_ABI_DIR_CCW;
-    }
-    
-    settings |= AS5047P_ABI_ENABLE;  // Enable ABI
-    
-    if (enableIndex) {
-        settings |= AS5047P_ABI_INDEX_ENABLE;
-    }
-    
-    // Write ABI_SETTINGS register
-    bool writeSuccess = writeRegister(AS5047P_REG_ABI_SETTINGS, settings);
-    
-    ::delay(10);  // Wait for register to update
-    
-    // Verify by checking key bits instead of exact match
-    uint16_t readback = readABISettings();
-    
-    // If writeRegister returned true, the write likely succeeded
-    // Even if readback is 0x3FFF (write-only register), we trust the write
-    if (writeSuccess) {
-        // If readback is valid (not 0x3FFF), verify the settings
-        if (readback != 0x3FFF) {
-            // Check if ABI is enabled (most important check)
-            bool abiEnabled = (readback & AS5047P_ABI_ENABLE) != 0;
-            
-            // Check resolution bits (0-2)
-            bool resolutionMatch = ((readback & 0x07) == (settings & 0x07));
-            
-            // Success if ABI is enabled and at least resolution matches
-            return abiEnabled && resolutionMatch;
-        } else {
-            // Readback is 0x3FFF - register appears write-only
-            // Trust that write succeeded since writeRegister returned true
-            return true;
-        }
-    }
-    
-    return false;
-}
-
-bool as5047p_arduino::enableABI(){
-    uint16_t settings = readABISettings();
-    settings |= AS5047P_ABI_ENABLE;
-    return writeRegister(AS5047P_REG_ABI_SETTINGS, settings);
-}
-
-bool as5047p_arduino::disableABI(){
-    uint16_t settings = readABISettings();
-    settings &= ~AS5047P_ABI_ENABLE;
-    return writeRegister(AS5047P_REG_ABI_SETTINGS, settings);
-}
-
-uint16_t as5047p_arduino::readABISettings(){
-    return readRegister(AS5047P_REG_ABI_SETTINGS);
-}
-
-uint16_t as5047p_arduino::readABICtrl(){
-    return readRegister(AS5047P_REG_ABI_CTRL);
+    : as5047p_core<arduino_platform>(pin1, pin2, pin3, pin4, AS5047P_MISO_PULL) {
 }
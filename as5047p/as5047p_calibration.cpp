@@ -0,0 +1,216 @@
+/**
+ * @file as5047p_calibration.cpp
+ * @brief Implementation of AS5047P nonlinearity calibration
+ */
+
+#include "as5047p_calibration.h"
+
+// Shortest way round: [-AS5047P_ANGLE_HALF, AS5047P_ANGLE_HALF)
+static int32_t wrapAngle(int32_t diff){
+    return ((diff + AS5047P_ANGLE_HALF) & AS5047P_ANGLE_MASK) - AS5047P_ANGLE_HALF;
+}
+
+// build() work table, off the stack (the ESP32 loop task has 8 KB)
+static double build_err[AS5047P_CAL_SIZE];
+
+// CRC-16/CCITT-FALSE
+static uint16_t crc16(const uint8_t *buf, uint16_t len){
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)buf[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void put16(uint8_t *p, uint16_t v){
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get16(const uint8_t *p){
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint16_t as5047p_correction::save(uint8_t *buf, uint16_t len) const{
+    if (len < AS5047P_CAL_BLOB_SIZE) {
+        return 0;
+    }
+
+    put16(buf, (uint16_t)AS5047P_CAL_MAGIC);
+    put16(buf + 2, (uint16_t)(AS5047P_CAL_MAGIC >> 16));
+    buf[4] = AS5047P_CAL_VERSION;
+    buf[5] = AS5047P_CAL_BITS;
+    put16(buf + 6, 0);
+    for (int i = 0; i < AS5047P_CAL_SIZE; i++) {
+        put16(buf + 8 + 2 * i, (uint16_t)table[i]);
+    }
+    put16(buf + AS5047P_CAL_BLOB_SIZE - 2, crc16(buf, AS5047P_CAL_BLOB_SIZE - 2));
+
+    return AS5047P_CAL_BLOB_SIZE;
+}
+
+bool as5047p_correction::load(const uint8_t *buf, uint16_t len){
+    if (len < AS5047P_CAL_BLOB_SIZE) {
+        return false;
+    }
+
+    uint32_t magic = get16(buf) | ((uint32_t)get16(buf + 2) << 16);
+    if (magic != AS5047P_CAL_MAGIC || buf[4] != AS5047P_CAL_VERSION || buf[5] != AS5047P_CAL_BITS) {
+        return false;
+    }
+    if (get16(buf + AS5047P_CAL_BLOB_SIZE - 2) != crc16(buf, AS5047P_CAL_BLOB_SIZE - 2)) {
+        return false;
+    }
+
+    for (int i = 0; i < AS5047P_CAL_SIZE; i++) {
+        table[i] = (int16_t)get16(buf + 8 + 2 * i);
+    }
+    return true;
+}
+
+as5047p_calibrator::as5047p_calibrator(){
+    reset();
+}
+
+void as5047p_calibrator::reset(){
+    for (int i = 0; i < AS5047P_CAL_SIZE; i++) {
+        count[i] = 0;
+        sum[i] = 0;
+        sum_t[i] = 0;
+    }
+    mode = MODE_NONE;
+    ref_offset = 0;
+    last_raw = 0;
+    last_us = 0;
+    unwrapped = 0;
+    elapsed_us = 0;
+    samples = 0;
+}
+
+uint8_t as5047p_calibrator::startMode(uint8_t next){
+    // Switching reference discards what was recorded against the other one
+    if (mode != next) {
+        reset();
+        mode = next;
+    }
+    return mode;
+}
+
+void as5047p_calibrator::accumulate(uint16_t raw, int64_t value, uint64_t t){
+    // Nearest bin centre
+    uint16_t bin = (uint16_t)(((raw + (AS5047P_CAL_STEP >> 1)) >> AS5047P_CAL_SHIFT) & (AS5047P_CAL_SIZE - 1));
+    if (count[bin] == 0xFFFF) {
+        return;
+    }
+    count[bin]++;
+    sum[bin] += value;
+    sum_t[bin] += t;
+}
+
+void as5047p_calibrator::addEncoderSample(uint16_t raw, int64_t count, uint32_t cpr){
+    startMode(MODE_ENCODER);
+    if (cpr == 0) {
+        return;
+    }
+    raw &= AS5047P_ANGLE_MASK;
+
+    int64_t pos = count % (int64_t)cpr;
+    if (pos < 0) {
+        pos += cpr;
+    }
+    int32_t ref = (int32_t)(((uint64_t)pos << AS5047P_ANGLE_BITS) / cpr);
+
+    // Take out the zero offset first so the error never sits near +/- half a turn
+    if (samples == 0) {
+        ref_offset = wrapAngle(ref - raw);
+    }
+    samples++;
+
+    accumulate(raw, wrapAngle(ref - raw - ref_offset), 0);
+}
+
+void as5047p_calibrator::addSweepSample(uint16_t raw, uint32_t t_us){
+    startMode(MODE_SWEEP);
+    raw &= AS5047P_ANGLE_MASK;
+
+    if (samples == 0) {
+        unwrapped = raw;
+        ref_offset = raw;
+    } else {
+        unwrapped += wrapAngle(raw - last_raw);
+        elapsed_us += (uint32_t)(t_us - last_us);
+    }
+    last_raw = raw;
+    last_us = t_us;
+    samples++;
+
+    accumulate(raw, unwrapped, elapsed_us);
+}
+
+uint16_t as5047p_calibrator::getCoverage() const{
+    uint16_t filled = 0;
+    for (int i = 0; i < AS5047P_CAL_SIZE; i++) {
+        filled += count[i] ? 1 : 0;
+    }
+    return filled;
+}
+
+bool as5047p_calibrator::build(as5047p_correction *out) const{
+    if (getCoverage() == 0 || (mode == MODE_SWEEP && elapsed_us == 0)) {
+        return false;
+    }
+
+    // Mean error per bin (reference - angle). For a sweep the reference is
+    // the straight line through the first and the last sample.
+    double *err = build_err;
+    double speed = 0.0;
+    if (mode == MODE_SWEEP) {
+        speed = (double)(unwrapped - ref_offset) / (double)elapsed_us;
+    }
+    for (int i = 0; i < AS5047P_CAL_SIZE; i++) {
+        if (!count[i]) {
+            continue;
+        }
+        if (mode == MODE_SWEEP) {
+            err[i] = ref_offset + speed * ((double)sum_t[i] / count[i]) - (double)sum[i] / count[i];
+        } else {
+            err[i] = (double)sum[i] / count[i];
+        }
+    }
+
+    // Fill empty bins from the nearest filled bins on either side (circular).
+    // Only filled bins are read, so this can run in place.
+    for (int i = 0; i < AS5047P_CAL_SIZE; i++) {
+        if (count[i]) {
+            continue;
+        }
+        int lo = 1, hi = 1;
+        while (!count[(i - lo) & (AS5047P_CAL_SIZE - 1)]) {
+            lo++;
+        }
+        while (!count[(i + hi) & (AS5047P_CAL_SIZE - 1)]) {
+            hi++;
+        }
+        double a = err[(i - lo) & (AS5047P_CAL_SIZE - 1)];
+        double b = err[(i + hi) & (AS5047P_CAL_SIZE - 1)];
+        err[i] = a + (b - a) * lo / (lo + hi);
+    }
+
+    // Remove the constant offset, round and store
+    double mean = 0.0;
+    for (int i = 0; i < AS5047P_CAL_SIZE; i++) {
+        mean += err[i];
+    }
+    mean /= AS5047P_CAL_SIZE;
+
+    for (int i = 0; i < AS5047P_CAL_SIZE; i++) {
+        double c = err[i] - mean;
+        if (c > AS5047P_ANGLE_HALF - 1) c = AS5047P_ANGLE_HALF - 1;
+        if (c < -AS5047P_ANGLE_HALF) c = -AS5047P_ANGLE_HALF;
+        out->setEntry((uint16_t)i, (int16_t)(c < 0 ? c - 0.5 : c + 0.5));
+    }
+    return true;
+}
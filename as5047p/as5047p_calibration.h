@@ -0,0 +1,197 @@
+/**
+ * @file as5047p_calibration.h
+ * @brief AS5047P nonlinearity calibration and LUT correction
+ *
+ * Off-axis or tilted magnets make the AS5047P angle error a smooth,
+ * repeatable function of the angle. as5047p_calibrator records that error
+ * against a reference and builds an as5047p_correction table from it.
+ *
+ * Reference options:
+ * - addEncoderSample(): a high-resolution incremental encoder on the same
+ *   shaft (e.g. LS7366R_Single::getCount())
+ * - addSweepSample(): a constant-speed sweep over whole turns, where time
+ *   is the reference
+ *
+ * The table holds AS5047P_CAL_SIZE corrections (raw counts) at bin
+ * centres idx * AS5047P_CAL_STEP. apply() interpolates linearly between
+ * the two neighbouring entries with no branches: a shift, a mask, two
+ * loads and one multiply per sample.
+ *
+ * The constant part of the error (reference zero vs magnet zero) is
+ * removed, so the correction does not move the zero position.
+ *
+ * Both references need the angle's own latch time. readAngleRaw() latches
+ * within the call; readAnglePipelined() returns the angle latched by the
+ * previous call, at getAngleMicros().
+ *
+ *   as5047p_correction lut;
+ *   as5047p_calibrator cal;
+ *   while (turning) {
+ *       uint16_t raw = sensor.readAngleRaw();
+ *       encoder.sync();
+ *       cal.addEncoderSample(raw, encoder.getCount(), 4 * 2048);
+ *   }
+ *   cal.build(&lut);
+ *
+ *   lut.load(blob, sizeof(blob));                 // or from a saved blob
+ *   sensor.setCorrection(&lut);
+ */
+
+#ifndef _AS5047P_CALIBRATION_H
+#define _AS5047P_CALIBRATION_H
+
+#include <stdint.h>
+#include "as5047p_angle.h"
+
+/** Table size (power of two) and raw counts per entry */
+#define AS5047P_CAL_BITS        8
+#define AS5047P_CAL_SIZE        (1 << AS5047P_CAL_BITS)
+#define AS5047P_CAL_SHIFT       (AS5047P_ANGLE_BITS - AS5047P_CAL_BITS)
+#define AS5047P_CAL_STEP        (1 << AS5047P_CAL_SHIFT)
+
+/** Binary blob: magic, version, table bits, reserved, table, CRC-16 (little endian) */
+#define AS5047P_CAL_MAGIC       0x4C433541  // "A5CL"
+#define AS5047P_CAL_VERSION     1
+#define AS5047P_CAL_BLOB_SIZE   (8 + 2 * AS5047P_CAL_SIZE + 2)
+
+class as5047p_correction{
+    private:
+        int16_t table[AS5047P_CAL_SIZE];    // Correction at each bin centre (raw counts)
+
+    public:
+        as5047p_correction(){
+            clear();
+        }
+
+        /** Reset to no correction */
+        void clear(){
+            for (int i = 0; i < AS5047P_CAL_SIZE; i++) {
+                table[i] = 0;
+            }
+        }
+
+        /** Correct a raw angle
+         *
+         *  @param raw  14-bit angle
+         *  @return     Corrected 14-bit angle
+         */
+        uint16_t apply(uint16_t raw) const{
+            uint32_t idx = (raw >> AS5047P_CAL_SHIFT) & (AS5047P_CAL_SIZE - 1);
+            int32_t frac = raw & (AS5047P_CAL_STEP - 1);
+            int32_t c0 = table[idx];
+            int32_t c1 = table[(idx + 1) & (AS5047P_CAL_SIZE - 1)];
+            int32_t corr = c0 + (((c1 - c0) * frac) >> AS5047P_CAL_SHIFT);
+            return (uint16_t)((raw + corr) & AS5047P_ANGLE_MASK);
+        }
+
+        /** Get one table entry
+         *
+         *  @param idx  Entry (0 .. AS5047P_CAL_SIZE - 1)
+         *  @return     Correction at idx * AS5047P_CAL_STEP (raw counts)
+         */
+        int16_t getEntry(uint16_t idx) const{
+            return table[idx & (AS5047P_CAL_SIZE - 1)];
+        }
+
+        /** Set one table entry
+         *
+         *  @param idx          Entry (0 .. AS5047P_CAL_SIZE - 1)
+         *  @param correction   Correction (raw counts)
+         */
+        void setEntry(uint16_t idx, int16_t correction){
+            table[idx & (AS5047P_CAL_SIZE - 1)] = correction;
+        }
+
+        /** Write the table as a binary blob
+         *
+         *  @param buf  Destination
+         *  @param len  Size of buf
+         *  @return     Bytes written (AS5047P_CAL_BLOB_SIZE), 0 if buf is too small
+         */
+        uint16_t save(uint8_t *buf, uint16_t len) const;
+
+        /** Read the table from a binary blob
+         *
+         *  The table is left unchanged if the blob is invalid.
+         *
+         *  @param buf  Blob written by save()
+         *  @param len  Size of buf
+         *  @return     false on a wrong size, magic, version or CRC
+         */
+        bool load(const uint8_t *buf, uint16_t len);
+};
+
+class as5047p_calibrator{
+    private:
+        enum {
+            MODE_NONE,
+            MODE_ENCODER,
+            MODE_SWEEP
+        };
+
+        // Per bin: number of samples, sum of error (encoder) or unwrapped angle (sweep), sum of time
+        uint16_t count[AS5047P_CAL_SIZE];
+        int64_t sum[AS5047P_CAL_SIZE];
+        uint64_t sum_t[AS5047P_CAL_SIZE];
+
+        uint8_t mode;
+
+        int32_t ref_offset;     // Encoder: reference - angle at the first sample; sweep: first angle
+
+        // Sweep state
+        uint16_t last_raw;
+        uint32_t last_us;
+        int64_t unwrapped;
+        uint64_t elapsed_us;
+        uint32_t samples;
+
+        uint8_t startMode(uint8_t mode);
+        void accumulate(uint16_t raw, int64_t value, uint64_t t);
+
+    public:
+        as5047p_calibrator();
+
+        /** Drop all recorded samples */
+        void reset();
+
+        /** Record one sample against an incremental encoder
+         *
+         *  The encoder must count in the same direction as the AS5047P.
+         *  Latch the count right after a fresh angle (readAngleRaw(), or
+         *  restartAngle() before a pipelined read): a pipelined angle is
+         *  one call old and the speed times that age ends up in the table.
+         *
+         *  @param raw      AS5047P raw angle
+         *  @param count    Encoder count latched with raw
+         *  @param cpr      Encoder counts per revolution
+         */
+        void addEncoderSample(uint16_t raw, int64_t count, uint32_t cpr);
+
+        /** Record one sample of a constant-speed sweep
+         *
+         *  Sample for whole turns (either direction) at a steady speed with
+         *  less than half a turn between samples.
+         *
+         *  @param raw      AS5047P raw angle
+         *  @param t_us     Time raw was latched (getAngleMicros())
+         */
+        void addSweepSample(uint16_t raw, uint32_t t_us);
+
+        /** Get the number of table bins that have samples
+         *
+         *  @return     0 .. AS5047P_CAL_SIZE
+         */
+        uint16_t getCoverage() const;
+
+        /** Build the correction table
+         *
+         *  Empty bins are interpolated from their neighbours. Not
+         *  reentrant: all calibrators share one work table.
+         *
+         *  @param out  Table to fill
+         *  @return     false if no samples were recorded (out is unchanged)
+         */
+        bool build(as5047p_correction *out) const;
+};
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * @file as5047p_multiturn.cpp
+ * @brief Implementation of AS5047P multi-turn tracking
+ */
+
+#include "as5047p_multiturn.h"
+
+as5047p_multiturn::as5047p_multiturn(uint16_t guard)
+    : position(0), last_raw(0), last_step(0),
+      guard(guard < AS5047P_MT_HALF_TURN ? guard : AS5047P_MT_HALF_TURN - 1),
+      primed(false), overspeed(false), guard_trips(0) {
+}
+
+void as5047p_multiturn::reset(uint16_t raw, int32_t turns){
+    raw &= AS5047P_ANGLE_MASK;
+    position = (int64_t)turns * AS5047P_MT_COUNTS_PER_TURN + raw;
+    last_raw = raw;
+    last_step = 0;
+    primed = true;
+}
+
+int64_t as5047p_multiturn::update(uint16_t raw){
+    raw &= AS5047P_ANGLE_MASK;
+
+    if (!primed) {
+        reset(raw);
+        return position;
+    }
+
+    // Shortest way round: step in [-half turn, half turn)
+    int16_t step = (int16_t)(((raw - last_raw + AS5047P_MT_HALF_TURN) & AS5047P_ANGLE_MASK) - AS5047P_MT_HALF_TURN);
+
+    if (step > (int16_t)guard || step < -(int16_t)guard) {
+        overspeed = true;
+        guard_trips++;
+    }
+
+    position += step;
+    last_raw = raw;
+    last_step = step;
+
+    return position;
+}
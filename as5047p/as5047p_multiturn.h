@@ -0,0 +1,97 @@
+/**
+ * @file as5047p_multiturn.h
+ * @brief Multi-turn absolute position tracking for the AS5047P
+ *
+ * Unwraps the 14-bit ANGLECOM value into a 64-bit position in raw counts
+ * (16384 per turn). Each sample is taken as the shortest way round from
+ * the previous one, so up to half a turn between samples is tracked
+ * correctly.
+ *
+ * Close to half a turn per sample the direction becomes ambiguous, so a
+ * guard flags steps larger than a configurable limit (a quarter turn by
+ * default). A trip means the poll rate is too low for the observed speed
+ * and the position may have slipped by whole turns.
+ *
+ * Integer math only, constant cost per sample.
+ *
+ *   as5047p_multiturn turns;
+ *   int64_t pos = turns.update(sensor.readRegister(AS5047P_REG_ANGLECOM));
+ */
+
+#ifndef _AS5047P_MULTITURN_H
+#define _AS5047P_MULTITURN_H
+
+#include <stdint.h>
+#include "as5047p_angle.h"
+
+#define AS5047P_MT_COUNTS_PER_TURN  (AS5047P_ANGLE_MASK + 1)
+#define AS5047P_MT_HALF_TURN        AS5047P_ANGLE_HALF
+
+/** Default guard: a quarter turn per sample */
+#define AS5047P_MT_GUARD_DEFAULT    (AS5047P_ANGLE_HALF / 2)
+
+class as5047p_multiturn{
+    private:
+        int64_t position;       // Raw counts, unwrapped
+        uint16_t last_raw;
+        int16_t last_step;
+        uint16_t guard;
+        bool primed;
+        bool overspeed;         // Sticky until clearOverspeed()
+        uint32_t guard_trips;
+
+    public:
+        /** Creates as5047p_multiturn object with specific content.
+         *
+         *  @param guard    Largest step per sample before flagging (counts, < AS5047P_MT_HALF_TURN)
+         */
+        as5047p_multiturn(uint16_t guard = AS5047P_MT_GUARD_DEFAULT);
+
+        /** Set the position from a raw angle and a turn number
+         *
+         *  @param raw      14-bit angle
+         *  @param turns    Whole turns
+         */
+        void reset(uint16_t raw, int32_t turns = 0);
+
+        /** Feed one ANGLECOM sample
+         *
+         *  The first sample after construction sets the position to turn 0.
+         *
+         *  @param raw      14-bit angle
+         *  @return         Position (raw counts)
+         */
+        int64_t update(uint16_t raw);
+
+        /** Get the position
+         *
+         *  @return     Position (raw counts, 16384 per turn)
+         */
+        int64_t getPosition() const { return position; }
+
+        /** Get the whole turns (floor)
+         *
+         *  @return     Turns
+         */
+        int32_t getTurns() const { return (int32_t)(position >> AS5047P_ANGLE_BITS); }
+
+        /** Get the step of the last sample
+         *
+         *  @return     Counts moved since the previous sample
+         */
+        int16_t getLastStep() const { return last_step; }
+
+        /** Check the poll-rate guard
+         *
+         *  @return     true if a step larger than the guard was seen
+         */
+        bool isOverspeed() const { return overspeed; }
+
+        /** Get the number of samples that tripped the guard */
+        uint32_t getGuardTrips() const { return guard_trips; }
+
+        /** Clear the overspeed flag */
+        void clearOverspeed() { overspeed = false; }
+};
+
+#endif
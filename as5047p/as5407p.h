@@ -2,36 +2,23 @@
 #define _AS5407P_H
 
 #include "mbed.h"
-
-class as5407p{
-    private:
-        DigitalOut cs;
-        DigitalIn miso;
-        DigitalOut clk;
-
-        void begin();
-        void end();
-
-        void delay_short();
-        void delay();
-        void long_delay();
-
-        void receive16(uint16_t *buf);
-
+#include "platform_mbed.h"
+#include "as5047p_core.h"
+
+/**
+ * mbed wrapper over as5047p_core. Without MOSI the sensor is read
+ * listen-only (ANGLECOM); with MOSI the full register API works.
+ */
+class as5407p : public as5047p_core<mbed_platform>{
     public:
         /** Creates as5407p object with specific content.
          *
          *  @param pin1     CS Pin
          *  @param pin2     MISO Pin
          *  @param pin3     CLK Pin
+         *  @param pin4     MOSI Pin (optional, for register access)
          */
-        as5407p(PinName pin1, PinName pin2, PinName pin3);  //cs, miso, clk
-
-        /** Get the angle (deg)
-         *
-         *  @return     get the angle (deg)
-         */
-        float readAngle();
+        as5407p(PinName pin1, PinName pin2, PinName pin3, PinName pin4 = NC);  //cs, miso, clk, mosi
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+/**
+ * @file bench.h
+ * @brief Minimal timing helpers for host benchmarks
+ *
+ * Host only. Each benchmark is a standalone program that prints one line
+ * per measurement:
+ *
+ *   <name> <ns per op> ns/op
+ *
+ * bench_suite runs the driver hot paths as one fixed set of cases, with
+ * CSV output and comparison against a saved baseline; use it to put
+ * numbers behind a driver change. The other programs each study one
+ * design question.
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <chrono>
+
+/** Keeps results alive so the optimizer cannot drop the measured code */
+static volatile int64_t bench_sink;
+
+static inline uint64_t bench_now_ns(){
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline void bench_report(const char *name, uint64_t elapsed_ns, uint64_t ops){
+    printf("%-40s %8.2f ns/op\n", name, ops ? (double)elapsed_ns / (double)ops : 0.0);
+}
+
+#endif
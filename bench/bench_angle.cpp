@@ -0,0 +1,80 @@
+/**
+ * @file bench_angle.cpp
+ * @brief Host benchmark: AS5047P raw angle conversion paths
+ *
+ * Compares the original float formula with the integer helpers in
+ * as5047p_angle.h, and the int -> float -> int round trip that control
+ * code used to do with readAngle(), and the cost of the nonlinearity
+ * correction lookup (as5047p_correction::apply).
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -I bench -I as5047p bench/bench_angle.cpp -o bench_angle
+ *   ./bench_angle
+ */
+
+#include "bench.h"
+#include "as5047p_angle.h"
+#include "as5047p_calibration.h"
+
+#define BENCH_SAMPLES   (1 << 14)
+#define BENCH_ROUNDS    4000
+
+static uint16_t samples[BENCH_SAMPLES];
+static as5047p_correction lut;
+
+// readAngle() before the integer API
+static float legacyDeg(uint16_t pos){
+    return (float)(pos * 360.0f) / 16384.0f;
+}
+
+template <class F>
+static void run(const char *name, F convert){
+    int64_t acc = 0;
+    uint64_t start = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int i = 0; i < BENCH_SAMPLES; i++) {
+            acc += convert(samples[i]);
+        }
+        bench_sink = acc;
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_report(name, elapsed, (uint64_t)BENCH_ROUNDS * BENCH_SAMPLES);
+}
+
+struct legacy_deg_to_centideg { int64_t operator()(uint16_t raw) const { return (int64_t)(legacyDeg(raw) * 100.0f); } };
+struct float_deg_to_centideg { int64_t operator()(uint16_t raw) const { return (int64_t)(as5047p_raw_to_deg(raw) * 100.0f); } };
+struct int_centideg { int64_t operator()(uint16_t raw) const { return as5047p_raw_to_centideg(raw); } };
+struct int_q16 { int64_t operator()(uint16_t raw) const { return as5047p_raw_to_q16(raw); } };
+struct int_mrad { int64_t operator()(uint16_t raw) const { return as5047p_raw_to_mrad(raw); } };
+struct lut_apply { int64_t operator()(uint16_t raw) const { return lut.apply(raw); } };
+
+int main(){
+    // Opaque input so the conversions are not folded at compile time
+    uint32_t rng = 1;
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        samples[i] = (uint16_t)(rng >> 18);
+    }
+    for (int i = 0; i < AS5047P_CAL_SIZE; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        lut.setEntry((uint16_t)i, (int16_t)((int32_t)(rng >> 26) - 32));
+    }
+
+    run("legacy float mul+div -> int", legacy_deg_to_centideg());
+    run("float mul -> int", float_deg_to_centideg());
+    run("as5047p_raw_to_centideg", int_centideg());
+    run("as5047p_raw_to_q16", int_q16());
+    run("as5047p_raw_to_mrad", int_mrad());
+    run("as5047p_correction::apply", lut_apply());
+
+    // Rounding check against the exact value (float loses the ties)
+    int worst = 0;
+    for (uint16_t raw = 0; raw < 16384; raw++) {
+        int ref = (int)(raw * 36000.0 / 16384.0 + 0.5);
+        int diff = ref - (int)as5047p_raw_to_centideg(raw);
+        if (diff < 0) diff = -diff;
+        if (diff > worst) worst = diff;
+    }
+    printf("%-40s %8d centideg\n", "  max |exact - integer|", worst);
+    return 0;
+}
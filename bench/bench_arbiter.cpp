@@ -0,0 +1,222 @@
+/**
+ * @file bench_arbiter.cpp
+ * @brief Host harness: three LS7366R and a second device type on one SPI bus
+ *
+ * A timer "interrupt" (host_sim event, every TIMER_NS) reads encoder 1
+ * while the main loop reads encoders 2 and 3 and a device with other SPI
+ * settings. SPI transfers advance virtual time byte by byte, so the timer
+ * fires in the middle of the loop's transactions like a real interrupt.
+ * All three counters see the same forward-only signal, so every read must
+ * be monotonic and the final counts must equal the ground truth.
+ *
+ * Modes:
+ * - direct:   every caller opens its own SPI transaction (no arbiter)
+ * - arbiter:  everything goes through spi_arbiter; the loop posts its
+ *             three reads as one batch, LS7366R / other / LS7366R, which
+ *             the arbiter regroups by settings
+ *
+ * "wait" is how long the timer's read waited for the bus: at most the
+ * one loop transaction that was running when it fired.
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -I bench -I platform -I host -I host/arduino -I LS7366R -I bus \
+ *       bench/bench_arbiter.cpp host/host_sim.cpp host/quad_gen.cpp host/ls7366r_sim.cpp host/arduino/host_arduino.cpp \
+ *       LS7366R/LS7366R_Single.cpp bus/spi_arbiter.cpp -o bench_arbiter
+ *   ./bench_arbiter
+ */
+
+#include <stdio.h>
+#include "host_sim.h"
+#include "host_arduino.h"
+#include "ls7366r_sim.h"
+#include "quad_gen.h"
+#include "LS7366R_Single.h"
+#include "spi_arbiter.h"
+
+#define PIN_A           32
+#define PIN_B           33
+#define PIN_CS_1        5
+#define PIN_CS_2        15
+#define PIN_CS_3        4
+#define PIN_CS_OTHER    16
+
+#define RUN_NS          100000000ULL    // Signal time
+#define TIMER_NS        500000ULL       // Timer read of encoder 1
+#define TIMER_BUDGET_US 100
+#define LOOP_BUDGET_US  2000
+#define SIGNAL_RATE     100000          // Edges per second
+
+enum bench_mode{
+    MODE_DIRECT,
+    MODE_ARBITER
+};
+
+static const spi_bus_settings ls7366r_settings = { LS7366R_SPI_SPEED, LS7366R_SPI_BITORDER, LS7366R_SPI_MODE };
+static const spi_bus_settings other_settings = { 4000000, MSBFIRST, SPI_MODE1 };
+
+struct encoder_reader{
+    LS7366R_Single *encoder;
+    int32_t last;
+    uint32_t reads;
+    uint32_t backwards;
+};
+
+struct bench_state{
+    bench_mode mode;
+    spi_arbiter *arbiter;
+    encoder_reader timer_reader;
+    spi_transaction timer_t;
+    uint64_t timer_at;
+    uint32_t timer_skipped;
+    uint32_t timer_wait_max_us;
+    uint32_t timer_submit_us;
+    bool stop;
+};
+
+static void readEncoder(void *ctx){
+    encoder_reader *r = (encoder_reader*)ctx;
+    r->encoder->sync();
+    int32_t count = r->encoder->getCount();
+    if (r->reads && count < r->last) {
+        r->backwards++;
+    }
+    r->last = count;
+    r->reads++;
+}
+
+static void readOther(void *ctx){
+    (void)ctx;
+    digitalWrite(PIN_CS_OTHER, LOW);
+    SPI.transfer16(0xFFFF);
+    digitalWrite(PIN_CS_OTHER, HIGH);
+}
+
+static void onTimer(void *ctx){
+    bench_state *s = (bench_state*)ctx;
+
+    if (s->mode == MODE_DIRECT) {
+        readEncoder(&s->timer_reader);
+    } else if (s->timer_t.state == SPI_TRANSACTION_QUEUED) {
+        s->timer_skipped++;
+    } else {
+        if (s->timer_t.state == SPI_TRANSACTION_DONE) {
+            uint32_t wait = s->timer_t.start_us - s->timer_submit_us;
+            if (wait > s->timer_wait_max_us) {
+                s->timer_wait_max_us = wait;
+            }
+        }
+        s->timer_submit_us = micros();
+        s->arbiter->submit(&s->timer_t, TIMER_BUDGET_US);
+    }
+
+    if (!s->stop) {
+        s->timer_at += TIMER_NS;
+        host_sim::schedule(s->timer_at, onTimer, s);
+    }
+}
+
+static void runMode(bench_mode mode){
+    host_sim::reset();
+    host_arduino::reset();
+    quad_gen sig(PIN_A, PIN_B, -1, 7);
+    sig.setRate(SIGNAL_RATE);
+
+    ls7366r_sim chip1(PIN_CS_1, PIN_A, PIN_B);
+    ls7366r_sim chip2(PIN_CS_2, PIN_A, PIN_B);
+    ls7366r_sim chip3(PIN_CS_3, PIN_A, PIN_B);
+    LS7366R_Single enc1(PIN_CS_1), enc2(PIN_CS_2), enc3(PIN_CS_3);
+    enc1.begin();
+    enc2.begin();
+    enc3.begin();
+    pinMode(PIN_CS_OTHER, OUTPUT);
+    digitalWrite(PIN_CS_OTHER, HIGH);
+
+    bool managed = mode != MODE_DIRECT;
+    enc1.setExternalTransaction(managed);
+    enc2.setExternalTransaction(managed);
+    enc3.setExternalTransaction(managed);
+
+    spi_arbiter arbiter(SPI);
+    encoder_reader r2 = { &enc2, 0, 0, 0 };
+    encoder_reader r3 = { &enc3, 0, 0, 0 };
+    spi_transaction t2(readEncoder, &r2, &ls7366r_settings);
+    spi_transaction t3(readEncoder, &r3, &ls7366r_settings);
+    spi_transaction t_other(readOther, 0, &other_settings);
+
+    bench_state s;
+    s.mode = mode;
+    s.arbiter = &arbiter;
+    s.timer_reader.encoder = &enc1;
+    s.timer_reader.last = 0;
+    s.timer_reader.reads = 0;
+    s.timer_reader.backwards = 0;
+    s.timer_t = spi_transaction(readEncoder, &s.timer_reader, &ls7366r_settings, SPI_PRIORITY_HIGH);
+    s.timer_skipped = 0;
+    s.timer_wait_max_us = 0;
+    s.timer_submit_us = 0;
+    s.stop = false;
+
+    sig.start();
+    s.timer_at = host_sim::nanos() + TIMER_NS;
+    host_sim::schedule(s.timer_at, onTimer, &s);
+
+    uint32_t cycles = 0;
+    uint32_t direct_groups = 0;
+    uint64_t end_ns = host_sim::nanos() + RUN_NS;
+    while (host_sim::nanos() < end_ns) {
+        if (mode == MODE_DIRECT) {
+            readEncoder(&r2);
+            SPI.beginTransaction(SPISettings(other_settings.clock, other_settings.bit_order, other_settings.mode));
+            readOther(0);
+            SPI.endTransaction();
+            readEncoder(&r3);
+            direct_groups += 3;
+        } else {
+            arbiter.post(&t2, LOOP_BUDGET_US);
+            arbiter.post(&t_other, LOOP_BUDGET_US);
+            arbiter.post(&t3, LOOP_BUDGET_US);
+            arbiter.finish(&t2);
+            arbiter.finish(&t_other);
+            arbiter.finish(&t3);
+        }
+        cycles++;
+        host_sim::advance(20000);   // Rest of loop()
+    }
+
+    s.stop = true;
+    sig.stop();
+    host_sim::advance(2 * TIMER_NS);
+    if (managed) {
+        arbiter.finish(&s.timer_t);
+    }
+
+    enc1.setExternalTransaction(false);
+    enc2.setExternalTransaction(false);
+    enc3.setExternalTransaction(false);
+    enc1.sync();
+    enc2.sync();
+    enc3.sync();
+    int64_t truth = sig.getPosition();
+    uint32_t wrong = (enc1.getCount() != truth) + (enc2.getCount() != truth) + (enc3.getCount() != truth);
+    uint32_t backwards = s.timer_reader.backwards + r2.backwards + r3.backwards;
+
+    spi_arbiter_stats stats;
+    arbiter.getStats(&stats);
+    static const char *names[] = { "direct", "arbiter" };
+    uint32_t groups = managed ? stats.groups : direct_groups;
+    printf("%-8s %7u %8u %8u %7u %7.2f %6u %9u %8u %9u %9u\n",
+           names[mode], cycles, s.timer_reader.reads, s.timer_skipped,
+           groups, (double)groups / cycles, managed ? stats.late : 0,
+           managed ? stats.max_late_us : 0, s.timer_wait_max_us, backwards, wrong);
+}
+
+int main(){
+    printf("signal %u edges/s, timer every %llu us (budget %u us), loop budget %u us\n",
+           SIGNAL_RATE, (unsigned long long)(TIMER_NS / 1000), TIMER_BUDGET_US, LOOP_BUDGET_US);
+    printf("%-8s %7s %8s %8s %7s %7s %6s %9s %8s %9s %9s\n",
+           "mode", "cycles", "timer rd", "skipped", "groups", "/cycle", "late", "max late", "wait us",
+           "backwards", "wrong end");
+    runMode(MODE_DIRECT);
+    runMode(MODE_ARBITER);
+    return 0;
+}
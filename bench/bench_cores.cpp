@@ -0,0 +1,148 @@
+/**
+ * @file bench_cores.cpp
+ * @brief Host benchmark: portable driver cores on host_platform
+ *
+ * Measures abi_encoder_core::edge() per edge, getEdgeSnapshot() called
+ * directly and through decoder_position (position_source, should cost the
+ * same), and as5047p_core::readAngle() and readSample() per call against
+ * the simulated sensor. Host CPU time is reported as
+ * ns/op; bus time (driver delays) is reported in virtual time.
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -I bench -I platform -I host -I abi_encoder -I as5047p -I motion \
+ *       bench/bench_cores.cpp host/host_sim.cpp host/as5047p_sim.cpp -o bench_cores
+ *   ./bench_cores
+ */
+
+#include "bench.h"
+#include "platform_host.h"
+#include "host_sim.h"
+#include "as5047p_sim.h"
+#include "abi_encoder_core.h"
+#include "as5047p_core.h"
+#include "position_source.h"
+
+#define BENCH_EDGES     20000000
+#define BENCH_READS     200000
+#define BENCH_SNAPSHOTS 20000000
+
+#define PIN_CS          5
+#define PIN_MISO        19
+#define PIN_CLK         18
+#define PIN_MOSI        23
+
+static void benchDecoder(){
+    abi_encoder_core<host_platform> dec(4000);
+    dec.setLevels(0, 0);
+
+    // Forward quadrature: AB 00 -> 10 -> 11 -> 01 -> 00
+    static const uint8_t seq_ch[4] = { ABI_CHANNEL_A, ABI_CHANNEL_B, ABI_CHANNEL_A, ABI_CHANNEL_B };
+    static const uint8_t seq_ab[4] = { 0x2, 0x3, 0x1, 0x0 };
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_EDGES; i++) {
+        dec.edge(seq_ch[i & 3], seq_ab[i & 3] >> 1, seq_ab[i & 3] & 1);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_sink = dec.getAmountSPR();
+    bench_report("abi_encoder_core::edge", elapsed, BENCH_EDGES);
+
+    dec.setGlitchFilter(2);
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_EDGES; i++) {
+        host_sim::advance(5000);
+        dec.edge(seq_ch[i & 3], seq_ab[i & 3] >> 1, seq_ab[i & 3] & 1);
+    }
+    elapsed = bench_now_ns() - start;
+    bench_sink = dec.getAmountSPR();
+    bench_report("abi_encoder_core::edge (glitch filter)", elapsed, BENCH_EDGES);
+}
+
+template <class S>
+static int64_t samplePositions(position_source<S> &src, uint32_t n){
+    position_snapshot snap;
+    int64_t sum = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        src.sample(&snap);
+        sum += snap.count + snap.time_us + snap.status;
+    }
+    return sum;
+}
+
+static void benchPositionSource(){
+    abi_encoder_core<host_platform> dec(4000);
+    dec.setLevels(0, 0);
+    dec.edge(ABI_CHANNEL_A, 1, 0);
+
+    int64_t count;
+    uint32_t time_us;
+    int64_t sum = 0;
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_SNAPSHOTS; i++) {
+        dec.getEdgeSnapshot(&count, &time_us);
+        dec.getSPR();
+        sum += count + time_us + (dec.getIllegalTransitions() != 0);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_sink = sum;
+    bench_report("abi_encoder_core::getEdgeSnapshot", elapsed, BENCH_SNAPSHOTS);
+
+    decoder_position<abi_encoder_core<host_platform> > pos(dec);
+    start = bench_now_ns();
+    bench_sink = samplePositions(pos, BENCH_SNAPSHOTS);
+    elapsed = bench_now_ns() - start;
+    bench_report("decoder_position::sample", elapsed, BENCH_SNAPSHOTS);
+}
+
+static void benchSensor(){
+    as5047p_sim sim(PIN_CS, PIN_MISO, PIN_CLK, PIN_MOSI);
+    as5047p_core<host_platform> sensor(PIN_CS, PIN_MISO, PIN_CLK, PIN_MOSI);
+
+    sim.setAngle(8192);
+
+    float sum = 0.0f;
+    uint64_t bus_start = host_sim::nanos();
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_READS; i++) {
+        sum += sensor.readAngle();
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    uint64_t bus = host_sim::nanos() - bus_start;
+    bench_sink = (int64_t)sum;
+    bench_report("as5047p_core::readAngle (host cpu)", elapsed, BENCH_READS);
+    bench_report("as5047p_core::readAngle (bus delays)", bus, BENCH_READS);
+    printf("%-40s %8.2f deg (expected 180.00)\n", "  angle", sum / BENCH_READS);
+
+    // ANGLECOM + ANGLEUNC + DIAAGC: one pipelined burst vs three reads
+    as5047p_sample sample = as5047p_sample();
+    uint32_t failed = 0;
+    bus_start = host_sim::nanos();
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_READS; i++) {
+        failed += !sensor.readSample(&sample);
+    }
+    elapsed = bench_now_ns() - start;
+    bus = host_sim::nanos() - bus_start;
+    bench_sink = sample.angle + failed;
+    bench_report("as5047p_core::readSample (host cpu)", elapsed, BENCH_READS);
+    bench_report("as5047p_core::readSample (bus delays)", bus, BENCH_READS);
+
+    bus_start = host_sim::nanos();
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_READS; i++) {
+        bench_sink += sensor.readAngleRaw() + sensor.readAngleUncompensated() + sensor.readDiagnostics();
+    }
+    elapsed = bench_now_ns() - start;
+    bus = host_sim::nanos() - bus_start;
+    bench_report("as5047p_core::3x readRegister (host cpu)", elapsed, BENCH_READS);
+    bench_report("as5047p_core::3x readRegister (bus delays)", bus, BENCH_READS);
+    printf("%-40s %8u\n", "  failed samples", failed);
+}
+
+int main(){
+    host_sim::reset();
+    benchDecoder();
+    benchPositionSource();
+    benchSensor();
+    return 0;
+}
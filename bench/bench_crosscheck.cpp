@@ -0,0 +1,133 @@
+/**
+ * @file bench_crosscheck.cpp
+ * @brief Host harness: software ABI decoder vs LS7366R on the same signal
+ *
+ * Drives one quadrature signal (quad_gen) into abi_encoder_arduino (interrupts on
+ * the host Arduino stand-in) and LS7366R_Single (simulated counter) and
+ * sweeps the edge rate. At every rate both are sampled at the same
+ * virtual times while the signal runs, then compared exactly with the
+ * ground truth after it stops. The software decoder's limit comes from
+ * the interrupt model (host_arduino.h): latency to handler start and CPU
+ * time per handler, given per build on the command line. The signal has
+ * a little jitter and occasional reversals so both directions are
+ * exercised.
+ *
+ * "illegal" is the decoder's count of transitions with both channels
+ * changed, i.e. edges its handlers missed; "flagged" is the number of
+ * samples decoder_position marked POSITION_GLITCH. A channel that loses
+ * both edges of a pulse leaves no illegal transition, so at high rates
+ * the error can grow faster than these counters.
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -I bench -I platform -I host -I host/arduino -I abi_encoder -I LS7366R -I motion \
+ *       bench/bench_crosscheck.cpp host/host_sim.cpp host/quad_gen.cpp host/ls7366r_sim.cpp host/arduino/host_arduino.cpp \
+ *       abi_encoder/abi_encoder_arduino.cpp LS7366R/LS7366R_Single.cpp -o bench_crosscheck
+ *   ./bench_crosscheck [latency_ns isr_ns]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "host_sim.h"
+#include "host_arduino.h"
+#include "ls7366r_sim.h"
+#include "quad_gen.h"
+#include "abi_encoder_arduino.h"
+#include "LS7366R_Single.h"
+#include "position_source.h"
+
+#define PIN_A           32
+#define PIN_B           33
+#define PIN_CS          5
+
+#define RUN_NS          20000000ULL     // Signal time per rate
+#define SAMPLE_NS       1000000ULL      // Sample interval while running
+#define DRAIN_NS        1000000ULL      // Settling time before the final compare
+
+#define SIGNAL_SEED         12345
+#define SIGNAL_JITTER_PCT   10              // Jitter, % of the edge period
+#define SIGNAL_REVERSE_Q16  64              // ~1 reversal per 1000 edges
+
+// Default interrupt timing (ESP32, Arduino attachInterruptArg)
+#define DEFAULT_LATENCY_NS  2000
+#define DEFAULT_ISR_NS      500
+
+struct crosscheck_result{
+    int64_t truth;
+    int64_t hw_error;
+    int64_t sw_error;
+    int64_t max_divergence;     // |sw - hw| while running
+    uint32_t illegal;
+    uint32_t flagged;           // Samples with POSITION_GLITCH
+    uint32_t lost;
+};
+
+static crosscheck_result runRate(uint32_t rate, uint32_t latency_ns, uint32_t isr_ns){
+    host_sim::reset();
+    host_arduino::reset();
+    host_arduino::setInterruptTiming(latency_ns, isr_ns);
+    quad_gen sig(PIN_A, PIN_B, -1, SIGNAL_SEED);
+    sig.setRate(rate);
+    sig.setJitter((uint32_t)(1000000000ULL / rate * SIGNAL_JITTER_PCT / 100));
+    sig.setReversals(SIGNAL_REVERSE_Q16);
+
+    ls7366r_sim chip(PIN_CS, PIN_A, PIN_B);
+    LS7366R_Single hw(PIN_CS);
+    hw.begin();
+    abi_encoder_arduino sw(PIN_A, PIN_B);
+    decoder_position<abi_encoder_arduino> sw_pos(sw);
+
+    crosscheck_result r = crosscheck_result();
+
+    uint64_t start_ns = host_sim::nanos();
+    sig.start();
+
+    // Sample both at the same virtual times
+    for (uint64_t t = SAMPLE_NS; t <= RUN_NS; t += SAMPLE_NS) {
+        host_sim::advance(start_ns + t - host_sim::nanos());
+        hw.sync();
+        position_snapshot snap;
+        sw_pos.sample(&snap);
+        if (snap.status & POSITION_GLITCH) r.flagged++;
+        int64_t d = sw.getAmountSPR() - hw.getCount();
+        if (d < 0) d = -d;
+        if (d > r.max_divergence) r.max_divergence = d;
+    }
+
+    sig.stop();
+    host_sim::advance(DRAIN_NS);
+    hw.sync();
+
+    r.truth = sig.getPosition();
+    r.hw_error = (int64_t)(int32_t)hw.getCount() - r.truth;
+    r.sw_error = sw.getAmountSPR() - r.truth;
+    r.illegal = sw.getIllegalTransitions();
+    r.lost = host_arduino::getLostInterrupts();
+    return r;
+}
+
+int main(int argc, char **argv){
+    uint32_t latency_ns = argc > 2 ? (uint32_t)atol(argv[1]) : DEFAULT_LATENCY_NS;
+    uint32_t isr_ns = argc > 2 ? (uint32_t)atol(argv[2]) : DEFAULT_ISR_NS;
+
+    printf("interrupt latency %u ns, handler %u ns\n", latency_ns, isr_ns);
+    printf("%12s %10s %9s %9s %9s %9s %9s %9s\n",
+           "edges/s", "truth", "hw err", "sw err", "max div", "illegal", "flagged", "lost");
+
+    uint32_t max_safe = 0;
+    bool failed = false;
+    for (uint32_t rate = 1000; rate <= 20000000; rate = rate * 5 / 4) {
+        crosscheck_result r = runRate(rate, latency_ns, isr_ns);
+        printf("%12u %10lld %9lld %9lld %9lld %9u %9u %9u\n",
+               rate, (long long)r.truth, (long long)r.hw_error,
+               (long long)r.sw_error, (long long)r.max_divergence, r.illegal, r.flagged, r.lost);
+
+        if (r.sw_error == 0 && r.hw_error == 0 && r.illegal == 0 && !failed) {
+            max_safe = rate;
+        } else {
+            failed = true;
+        }
+    }
+
+    printf("max safe edge rate (software decoder): %u edges/s\n", max_safe);
+    return 0;
+}
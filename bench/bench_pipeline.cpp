@@ -0,0 +1,210 @@
+/**
+ * @file bench_pipeline.cpp
+ * @brief Host benchmark: two-core acquisition -> processing pipeline
+ *
+ * The ESP32 split (acquisition task on one core, loop() on the other,
+ * snapshot_ring in between) with std::thread stand-ins:
+ *
+ * - throughput: the producer pushes as fast as it can, the consumer
+ *   drains; ns per record across the two threads
+ * - latency: the producer pushes one timestamped record every
+ *   LATENCY_GAP_NS, the consumer spins on pop(); push-to-pop time
+ * - sampler: encoder_sampler<thread_platform> at SAMPLER_RATE with a
+ *   source that costs SOURCE_NS per read, consumer polling every
+ *   CONSUME_US; achieved period, jitter, overruns, drops
+ *
+ * Threads are pinned to CPUs PRODUCER_CORE / CONSUMER_CORE where the
+ * machine has them. With a single CPU the two threads time-share and the
+ * numbers measure the scheduler, not the queue.
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -pthread -I bench -I platform -I sampler -I motion \
+ *       bench/bench_pipeline.cpp -o bench_pipeline
+ *   ./bench_pipeline
+ */
+
+#define PLATFORM_TIMER_CORE     0       // Acquisition core, as on the ESP32
+
+#include <algorithm>
+#include <vector>
+#include "bench.h"
+#include "platform_thread.h"
+#include "snapshot_ring.h"
+#include "encoder_sampler.h"
+
+#define PRODUCER_CORE       0
+#define CONSUMER_CORE       1
+
+#define THROUGHPUT_RECORDS  20000000
+#define LATENCY_RECORDS     200000
+#define LATENCY_GAP_NS      5000
+
+#define SAMPLER_RATE        10000       // Hz
+#define SAMPLER_RUN_MS      2000
+#define SOURCE_NS           20000       // Cost of one source read (LS7366R sync is ~126 us at 500 kHz)
+#define CONSUME_US          1000
+
+/** Same size class as encoder_snapshot, with a ns timestamp for latency */
+struct bench_record{
+    uint64_t time_ns;
+    uint32_t seq;
+    int32_t value[ENCODER_SAMPLER_SOURCES];
+};
+
+static snapshot_ring<bench_record, ENCODER_SAMPLER_BUFFER> ring;
+
+/** One CPU: busy waits must yield or the other thread never runs */
+static bool shared_cpu;
+
+static void relax(){
+    if (shared_cpu) {
+        std::this_thread::yield();
+    }
+}
+
+static void spinUntil(uint64_t t_ns){
+    while (bench_now_ns() < t_ns) {
+        relax();
+    }
+}
+
+static void producerThroughput(){
+    thread_platform::pinToCore(PRODUCER_CORE);
+    bench_record rec = bench_record();
+    for (uint32_t i = 0; i < THROUGHPUT_RECORDS; i++) {
+        rec.seq = i;
+        rec.value[0] = (int32_t)i;
+        while (!ring.push(rec)) {
+            relax();
+        }
+    }
+}
+
+static void benchThroughput(){
+    uint64_t t0 = bench_now_ns();
+    std::thread producer(producerThroughput);
+
+    bench_record rec;
+    uint32_t expect = 0;
+    uint32_t errors = 0;
+    while (expect < THROUGHPUT_RECORDS) {
+        if (!ring.pop(&rec)) {
+            relax();
+            continue;
+        }
+        if (rec.seq != expect || rec.value[0] != (int32_t)expect) {
+            errors++;
+        }
+        expect++;
+    }
+    uint64_t elapsed = bench_now_ns() - t0;
+    producer.join();
+
+    bench_report("snapshot_ring cross-thread push+pop", elapsed, THROUGHPUT_RECORDS);
+    printf("  %.1f M records/s, %u out of order\n",
+           (double)THROUGHPUT_RECORDS * 1000.0 / (double)elapsed, errors);
+}
+
+static void producerLatency(){
+    thread_platform::pinToCore(PRODUCER_CORE);
+    bench_record rec = bench_record();
+    uint64_t next = bench_now_ns();
+    for (uint32_t i = 0; i < LATENCY_RECORDS; i++) {
+        next += LATENCY_GAP_NS;
+        spinUntil(next);
+        rec.seq = i;
+        rec.time_ns = bench_now_ns();
+        ring.push(rec);
+    }
+}
+
+static void benchLatency(){
+    std::vector<uint32_t> latency;
+    latency.reserve(LATENCY_RECORDS);
+
+    std::thread producer(producerLatency);
+    bench_record rec;
+    uint64_t deadline = bench_now_ns() + (uint64_t)LATENCY_RECORDS * LATENCY_GAP_NS * 4;
+    while (latency.size() < LATENCY_RECORDS && bench_now_ns() < deadline) {
+        if (ring.pop(&rec)) {
+            latency.push_back((uint32_t)(bench_now_ns() - rec.time_ns));
+        } else {
+            relax();
+        }
+    }
+    producer.join();
+    while (ring.pop(&rec)) {
+    }
+
+    if (latency.empty()) {
+        printf("latency: no records received\n");
+        return;
+    }
+    uint64_t sum = 0;
+    for (size_t i = 0; i < latency.size(); i++) {
+        sum += latency[i];
+    }
+    std::sort(latency.begin(), latency.end());
+    printf("%-40s %8.2f ns/op\n", "snapshot_ring push->pop latency (mean)",
+           (double)sum / (double)latency.size());
+    printf("  p50 %u ns, p99 %u ns, max %u ns, %u of %u received\n",
+           latency[latency.size() / 2], latency[latency.size() * 99 / 100],
+           latency.back(), (unsigned)latency.size(), LATENCY_RECORDS);
+}
+
+static int32_t costlySource(void *ctx){
+    int32_t *count = (int32_t*)ctx;
+    spinUntil(bench_now_ns() + SOURCE_NS);
+    return ++*count;
+}
+
+static void benchSampler(){
+    static encoder_sampler<thread_platform> sampler;
+    int32_t count = 0;
+    sampler.addSource(costlySource, &count);
+
+    uint32_t consumed = 0;
+    uint32_t gaps = 0;
+    uint32_t last_seq = 0;
+    encoder_snapshot snap;
+
+    sampler.begin(SAMPLER_RATE);
+    uint64_t end = bench_now_ns() + (uint64_t)SAMPLER_RUN_MS * 1000000;
+    while (bench_now_ns() < end) {
+        thread_platform::delayMicros(CONSUME_US);
+        while (sampler.read(&snap)) {
+            if (consumed && snap.seq != last_seq + 1) {
+                gaps++;
+            }
+            last_seq = snap.seq;
+            consumed++;
+        }
+    }
+    sampler.end();
+    while (sampler.read(&snap)) {
+        consumed++;
+    }
+
+    encoder_sampler_stats stats;
+    sampler.getStats(&stats);
+    printf("encoder_sampler %u Hz, %u ns per read, consumer every %u us:\n",
+           SAMPLER_RATE, SOURCE_NS, CONSUME_US);
+    printf("  samples %u, consumed %u, period %u..%u us, jitter max %u us mean %u us\n",
+           stats.samples, consumed, stats.period_min_us, stats.period_max_us,
+           stats.jitter_max_us, stats.jitter_mean_us);
+    printf("  missed %u, overruns %u, dropped %u, consumer gaps %u\n",
+           stats.missed, stats.overruns, stats.dropped, gaps);
+}
+
+int main(){
+    bool pinned = thread_platform::pinToCore(CONSUMER_CORE);
+    shared_cpu = std::thread::hardware_concurrency() < 2;
+    printf("%u CPUs, consumer %s CPU %d, producer on CPU %d\n",
+           std::thread::hardware_concurrency(), pinned ? "pinned to" : "NOT pinned to",
+           CONSUMER_CORE, PRODUCER_CORE);
+
+    benchThroughput();
+    benchLatency();
+    benchSampler();
+    return 0;
+}
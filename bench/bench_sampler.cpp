@@ -0,0 +1,112 @@
+/**
+ * @file bench_sampler.cpp
+ * @brief Host harness: timer-driven encoder_sampler on a moving LS7366R
+ *
+ * Runs encoder_sampler on the host platform timer (host_sim virtual time)
+ * at several rates while quad_gen drives a simulated LS7366R. The main
+ * loop drains the ring every CONSUME_NS like a real loop() would. For
+ * each rate it reports the measured period range and jitter, missed and
+ * overrun ticks, dropped snapshots, sequence gaps seen by the consumer
+ * and the time one tick spends on the bus. A tick costs one
+ * LS7366R_Single::sync() at the driver's SPI clock, so rates whose period
+ * is shorter than that overrun and lose ticks.
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -I bench -I platform -I host -I host/arduino -I sampler -I motion -I LS7366R \
+ *       bench/bench_sampler.cpp host/host_sim.cpp host/quad_gen.cpp host/ls7366r_sim.cpp host/arduino/host_arduino.cpp \
+ *       LS7366R/LS7366R_Single.cpp -o bench_sampler
+ *   ./bench_sampler
+ */
+
+#include <stdio.h>
+#include "host_sim.h"
+#include "host_arduino.h"
+#include "platform_host.h"
+#include "ls7366r_sim.h"
+#include "quad_gen.h"
+#include "LS7366R_Single.h"
+#include "encoder_sampler.h"
+
+#define PIN_A           32
+#define PIN_B           33
+#define PIN_CS          5
+
+#define RUN_NS          200000000ULL    // Sampling time per rate
+#define CONSUME_NS      2000000ULL      // Main loop drains the ring this often
+#define SIGNAL_RATE     200000          // Edges per second
+
+struct sampler_result{
+    encoder_sampler_stats stats;
+    uint32_t consumed;
+    uint32_t seq_gaps;          // Snapshots missing between consecutive reads
+    uint32_t backwards;         // Counts going backwards (signal only moves forward)
+    uint32_t read_us_max;
+};
+
+static sampler_result runRate(uint32_t rate_hz){
+    host_sim::reset();
+    host_arduino::reset();
+    quad_gen sig(PIN_A, PIN_B, -1, 1);
+    sig.setRate(SIGNAL_RATE);
+
+    ls7366r_sim chip(PIN_CS, PIN_A, PIN_B);
+    LS7366R_Single counter(PIN_CS);
+    counter.begin();
+
+    encoder_sampler<host_platform> sampler;
+    sampler.addCounter(counter);
+
+    sampler_result r = sampler_result();
+    sig.start();
+    sampler.begin(rate_hz);
+
+    bool first = true;
+    uint32_t last_seq = 0;
+    int32_t last_value = 0;
+    uint64_t end_ns = host_sim::nanos() + RUN_NS;
+    while (host_sim::nanos() < end_ns) {
+        host_sim::advance(CONSUME_NS);
+
+        encoder_snapshot snap;
+        while (sampler.read(&snap)) {
+            if (!first) {
+                r.seq_gaps += snap.seq - last_seq - 1;
+                if (snap.value[0] < last_value) {
+                    r.backwards++;
+                }
+            }
+            if (snap.read_us > r.read_us_max) {
+                r.read_us_max = snap.read_us;
+            }
+            first = false;
+            last_seq = snap.seq;
+            last_value = snap.value[0];
+            r.consumed++;
+        }
+    }
+
+    sampler.end();
+    sig.stop();
+    sampler.getStats(&r.stats);
+    return r;
+}
+
+int main(){
+    static const uint32_t rates[] = {1000, 2000, 5000, 7500, 10000, 20000};
+
+    printf("signal %u edges/s, consumer every %llu us\n",
+           SIGNAL_RATE, (unsigned long long)(CONSUME_NS / 1000));
+    printf("%7s %8s %8s %8s %8s %8s %8s %8s %8s %8s %8s\n",
+           "rate", "samples", "min us", "max us", "jit max", "jit avg",
+           "missed", "overrun", "dropped", "gaps", "read us");
+
+    for (unsigned i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        sampler_result r = runRate(rates[i]);
+        printf("%7u %8u %8u %8u %8u %8u %8u %8u %8u %8u %8u%s\n",
+               rates[i], r.stats.samples, r.stats.period_min_us, r.stats.period_max_us,
+               r.stats.jitter_max_us, r.stats.jitter_mean_us, r.stats.missed,
+               r.stats.overruns, r.stats.dropped, r.seq_gaps, r.read_us_max,
+               r.backwards ? "  COUNT WENT BACKWARDS" : "");
+    }
+    return 0;
+}
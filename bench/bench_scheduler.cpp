@@ -0,0 +1,100 @@
+/**
+ * @file bench_scheduler.cpp
+ * @brief Host harness: rate-monotonic poll_scheduler on virtual time
+ *
+ * Registers a typical mix on host_platform (host_sim virtual time; each
+ * operation "costs" its bus time with delayMicros):
+ *
+ * - counts         10 kHz
+ * - cross-check     1 kHz  (every CROSS_SLOW_EVERY-th run is slow: overrun)
+ * - STR x2         10 Hz
+ * - diagnostics    10 Hz
+ *
+ * and reports the schedule (slot length, major cycle, phases), the planned
+ * load of the busiest slot against the naive "everything in phase 0"
+ * placement, and what was measured over RUN_NS.
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -I bench -I platform -I host -I sampler \
+ *       bench/bench_scheduler.cpp host/host_sim.cpp -o bench_scheduler
+ *   ./bench_scheduler
+ */
+
+#include <stdio.h>
+#include "host_sim.h"
+#include "platform_host.h"
+#include "poll_scheduler.h"
+
+#define RUN_NS              1000000000ULL   // 1 s of virtual time
+#define CROSS_SLOW_EVERY    100
+#define CROSS_SLOW_US       90
+
+struct bench_op{
+    const char *name;
+    uint32_t period_us;
+    uint16_t cost_us;
+    uint32_t calls;
+    bool slow;          // Cross-check: sometimes takes CROSS_SLOW_US
+};
+
+static void runOp(void *ctx){
+    bench_op *op = (bench_op*)ctx;
+    op->calls++;
+    uint32_t cost = op->cost_us;
+    if (op->slow && op->calls % CROSS_SLOW_EVERY == 0) {
+        cost = CROSS_SLOW_US;
+    }
+    host_platform::delayMicros(cost);
+}
+
+int main(){
+    static bench_op ops[] = {
+        { "counts",      100,    30, 0, false },
+        { "cross-check", 1000,   40, 0, true  },
+        { "STR 1",       100000, 20, 0, false },
+        { "STR 2",       100000, 20, 0, false },
+        { "diagnostics", 100000, 25, 0, false },
+    };
+    const int n = sizeof(ops) / sizeof(ops[0]);
+
+    host_sim::reset();
+    static poll_scheduler<host_platform> scheduler;
+    uint32_t naive_peak = 0;
+    for (int i = 0; i < n; i++) {
+        scheduler.addOperation(runOp, &ops[i], ops[i].period_us, ops[i].cost_us);
+        naive_peak += ops[i].cost_us;
+    }
+
+    poll_scheduler_status status = scheduler.begin();
+    printf("status %d, slot %u us, %u slots, planned utilization %u permille\n",
+           status, scheduler.getSlotMicros(), scheduler.getSlots(), scheduler.getUtilization());
+
+    host_sim::advance(RUN_NS);
+    scheduler.end();
+
+    uint32_t planned_peak = 0, planned_sum = 0, measured_peak = 0, busy_slots = 0;
+    for (uint16_t s = 0; s < scheduler.getSlots(); s++) {
+        uint16_t planned = scheduler.getSlotPlanned(s);
+        uint16_t measured = scheduler.getSlotMeasured(s);
+        planned_sum += planned;
+        if (planned > planned_peak) planned_peak = planned;
+        if (measured > measured_peak) measured_peak = measured;
+        if (planned > ops[0].cost_us) busy_slots++;
+    }
+    printf("busiest slot: planned %u us (naive phase 0: %u us), measured %u us; mean %u us\n",
+           planned_peak, naive_peak, measured_peak, planned_sum / scheduler.getSlots());
+    printf("slots with more than the 10 kHz operation: %u\n", busy_slots);
+    printf("slot overruns %u, missed ticks %u\n",
+           scheduler.getSlotOverruns(), scheduler.getMissedTicks());
+
+    printf("%-12s %8s %7s %6s %8s %8s %7s %7s\n",
+           "operation", "period", "budget", "phase", "runs", "overrun", "missed", "max us");
+    for (int i = 0; i < n; i++) {
+        poll_operation_stats st = poll_operation_stats();
+        scheduler.getOperationStats(i, &st);
+        printf("%-12s %8u %7u %6u %8u %8u %7u %7u\n",
+               ops[i].name, st.period_us, st.budget_us, st.phase, st.runs,
+               st.overruns, st.missed, st.max_us);
+    }
+    return 0;
+}
@@ -0,0 +1,570 @@
+/**
+ * @file bench_suite.cpp
+ * @brief Host benchmark suite: every driver hot path, with baseline comparison
+ *
+ * The regression target for performance changes in the drivers. The other
+ * programs in bench/ study one design question each; this one runs a fixed
+ * set of cases on the host simulators and reports, per case:
+ *
+ * - cpu: host CPU ns per op, the fastest of -r repeats
+ * - bus: virtual ns per op the driver spent waiting on the bus (host_sim
+ *        time: the delayMicroseconds() / P::delayMicros() calls, exact and
+ *        repeatable). The AS5047P bit clock is paced by CPU work, not
+ *        delays, so its frames show up in cpu; 0 for pure computations.
+ *
+ * Cases:
+ *   ls7366r.sync             LS7366R_Single::sync()
+ *   ls7366r.readStatus       LS7366R_Single::readStatus()
+ *   as5047p.frame            one full-duplex transfer16() frame (readRegister() / 2)
+ *   as5047p.readAngle        as5047p_core::readAngle(), MOSI wired
+ *   as5047p.readAnglePipelined  readAnglePipelined(), MOSI wired (one frame)
+ *   as5047p.readAngleListen  readAngleRaw() without MOSI (one receive frame)
+ *   as5047p.readSample       ANGLECOM + ANGLEUNC + DIAAGC burst
+ *   abi.edge                 abi_encoder_core::edge() per edge
+ *   abi.interrupt            abi_encoder_arduino A/B handler per edge, pin to count
+ *   angle.*                  as5047p_angle.h conversions, correction lookup
+ *   tracker.*                alpha_beta_tracker::update()
+ *   mt_velocity.snapshot     mt_velocity::updateSnapshot()
+ *
+ * Options:
+ *   -c          CSV on stdout: name,ops,cpu_ns,bus_ns
+ *   -s file     also save the results as CSV (a baseline)
+ *   -b file     compare with a saved baseline; exit 1 if a case got slower
+ *               than -t percent in cpu, or any slower in bus time
+ *   -t pct      cpu tolerance for -b (default 10)
+ *   -r n        repeats per case (default 5)
+ *   -f text     only the cases whose name contains text
+ *
+ *   ./bench_suite -s before.csv
+ *   (change a driver, rebuild)
+ *   ./bench_suite -b before.csv
+ *
+ * CPU numbers only compare on the same machine and build flags.
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -I bench -I platform -I host -I host/arduino -I LS7366R -I as5047p -I abi_encoder -I motion \
+ *       bench/bench_suite.cpp host/host_sim.cpp host/ls7366r_sim.cpp host/as5047p_sim.cpp host/arduino/host_arduino.cpp \
+ *       LS7366R/LS7366R_Single.cpp abi_encoder/abi_encoder_arduino.cpp motion/alpha_beta_tracker.cpp \
+ *       motion/mt_velocity.cpp -o bench_suite
+ *   ./bench_suite
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "host_sim.h"
+#include "host_arduino.h"
+#include "platform_host.h"
+#include "ls7366r_sim.h"
+#include "as5047p_sim.h"
+#include "LS7366R_Single.h"
+#include "as5047p_core.h"
+#include "abi_encoder_core.h"
+#include "abi_encoder_arduino.h"
+#include "alpha_beta_tracker.h"
+#include "mt_velocity.h"
+
+#define PIN_A           32
+#define PIN_B           33
+#define PIN_CS_COUNTER  5
+#define PIN_CS_SENSOR   7
+#define PIN_MISO        19
+#define PIN_CLK         18
+#define PIN_MOSI        23
+
+#define SUITE_CASES     32
+#define SUITE_NAME      40
+
+#define BUS_OPS         20000       // Simulated bus calls per run
+#define EDGE_OPS        2000000
+#define CONVERT_OPS     (1 << 14)   // Input table; run CONVERT_ROUNDS times
+#define CONVERT_ROUNDS  1000
+#define FILTER_OPS      1000000
+#define FILTER_PERIOD_US 100
+
+struct suite_result{
+    char name[SUITE_NAME];
+    uint64_t ops;
+    double cpu_ns;              // Per op
+    double bus_ns;              // Per op
+};
+
+/** One run of a case: ops done, host ns, virtual bus ns */
+struct suite_run{
+    uint64_t ops;
+    uint64_t cpu_ns;
+    uint64_t bus_ns;
+};
+
+typedef void (*suite_case_fn)(suite_run *run);
+
+struct suite_case{
+    const char *name;
+    suite_case_fn fn;
+};
+
+// Opaque inputs so the computations are not folded at compile time
+static uint16_t raw_samples[CONVERT_OPS];
+static int64_t filter_z[FILTER_OPS];
+static uint32_t filter_t[FILTER_OPS];
+static as5047p_correction lut;
+
+static void makeInputs(){
+    uint32_t rng = 1;
+    for (uint32_t i = 0; i < CONVERT_OPS; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        raw_samples[i] = (uint16_t)(rng >> 18);
+    }
+    for (uint32_t i = 0; i < AS5047P_CAL_SIZE; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        lut.setEntry((uint16_t)i, (int16_t)((int32_t)(rng >> 26) - 32));
+    }
+    // 20000 counts/s ramp with +/-2 counts of noise and a little jitter
+    for (uint32_t i = 0; i < FILTER_OPS; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        filter_z[i] = (int64_t)i * 2 + (int64_t)((rng >> 24) % 5) - 2;
+        filter_t[i] = i * FILTER_PERIOD_US + ((rng >> 8) & 3);
+    }
+}
+
+static void resetSim(){
+    host_sim::reset();
+    host_arduino::reset();
+}
+
+// ---------------------------------------------------------------------------
+// LS7366R
+// ---------------------------------------------------------------------------
+
+static void caseCounterSync(suite_run *run){
+    resetSim();
+    ls7366r_sim chip(PIN_CS_COUNTER, PIN_A, PIN_B);
+    LS7366R_Single counter(PIN_CS_COUNTER);
+    counter.begin();
+
+    uint64_t bus_start = host_sim::nanos();
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BUS_OPS; i++) {
+        counter.sync();
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = host_sim::nanos() - bus_start;
+    run->ops = BUS_OPS;
+    bench_sink = counter.getCount();
+}
+
+static void caseCounterStatus(suite_run *run){
+    resetSim();
+    ls7366r_sim chip(PIN_CS_COUNTER, PIN_A, PIN_B);
+    LS7366R_Single counter(PIN_CS_COUNTER);
+    counter.begin();
+
+    int64_t sum = 0;
+    uint64_t bus_start = host_sim::nanos();
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BUS_OPS; i++) {
+        sum += counter.readStatus();
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = host_sim::nanos() - bus_start;
+    run->ops = BUS_OPS;
+    bench_sink = sum;
+}
+
+// ---------------------------------------------------------------------------
+// AS5047P
+// ---------------------------------------------------------------------------
+
+// readRegister() is a command frame and a NOP frame: report per frame
+static void caseSensorFrame(suite_run *run){
+    resetSim();
+    as5047p_sim sim(PIN_CS_SENSOR, PIN_MISO, PIN_CLK, PIN_MOSI);
+    as5047p_core<host_platform> sensor(PIN_CS_SENSOR, PIN_MISO, PIN_CLK, PIN_MOSI);
+    sim.setAngle(1234);
+
+    int64_t sum = 0;
+    uint64_t bus_start = host_sim::nanos();
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BUS_OPS; i++) {
+        sum += sensor.readRegister(AS5047P_REG_DIAAGC);
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = host_sim::nanos() - bus_start;
+    run->ops = 2 * BUS_OPS;
+    bench_sink = sum;
+}
+
+static void caseSensorAngle(suite_run *run){
+    resetSim();
+    as5047p_sim sim(PIN_CS_SENSOR, PIN_MISO, PIN_CLK, PIN_MOSI);
+    as5047p_core<host_platform> sensor(PIN_CS_SENSOR, PIN_MISO, PIN_CLK, PIN_MOSI);
+    sim.setAngle(8192);
+
+    float sum = 0.0f;
+    uint64_t bus_start = host_sim::nanos();
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BUS_OPS; i++) {
+        sum += sensor.readAngle();
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = host_sim::nanos() - bus_start;
+    run->ops = BUS_OPS;
+    bench_sink = (int64_t)sum;
+}
+
+static void caseSensorPipelined(suite_run *run){
+    resetSim();
+    as5047p_sim sim(PIN_CS_SENSOR, PIN_MISO, PIN_CLK, PIN_MOSI);
+    as5047p_core<host_platform> sensor(PIN_CS_SENSOR, PIN_MISO, PIN_CLK, PIN_MOSI);
+    sim.setAngle(8192);
+
+    int64_t sum = 0;
+    uint64_t bus_start = host_sim::nanos();
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BUS_OPS; i++) {
+        uint16_t angle;
+        sensor.readAnglePipelined(&angle);
+        sum += angle;
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = host_sim::nanos() - bus_start;
+    run->ops = BUS_OPS;
+    bench_sink = sum;
+}
+
+static void caseSensorListen(suite_run *run){
+    resetSim();
+    as5047p_sim sim(PIN_CS_SENSOR, PIN_MISO, PIN_CLK, -1);
+    as5047p_core<host_platform> sensor(PIN_CS_SENSOR, PIN_MISO, PIN_CLK, host_platform::NO_PIN);
+    sim.setAngle(8192);
+
+    int64_t sum = 0;
+    uint64_t bus_start = host_sim::nanos();
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BUS_OPS; i++) {
+        sum += sensor.readAngleRaw();
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = host_sim::nanos() - bus_start;
+    run->ops = BUS_OPS;
+    bench_sink = sum;
+}
+
+static void caseSensorSample(suite_run *run){
+    resetSim();
+    as5047p_sim sim(PIN_CS_SENSOR, PIN_MISO, PIN_CLK, PIN_MOSI);
+    as5047p_core<host_platform> sensor(PIN_CS_SENSOR, PIN_MISO, PIN_CLK, PIN_MOSI);
+    sim.setAngle(8192);
+
+    as5047p_sample sample = as5047p_sample();
+    int64_t sum = 0;
+    uint64_t bus_start = host_sim::nanos();
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BUS_OPS; i++) {
+        sum += sensor.readSample(&sample);
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = host_sim::nanos() - bus_start;
+    run->ops = BUS_OPS;
+    bench_sink = sum + sample.angle;
+}
+
+// ---------------------------------------------------------------------------
+// Software ABI decoder
+// ---------------------------------------------------------------------------
+
+// Forward quadrature: AB 00 -> 10 -> 11 -> 01 -> 00
+static const uint8_t seq_channel[4] = { ABI_CHANNEL_A, ABI_CHANNEL_B, ABI_CHANNEL_A, ABI_CHANNEL_B };
+static const uint8_t seq_level[4] = { 1, 1, 0, 0 };
+static const uint8_t seq_ab[4] = { 0x2, 0x3, 0x1, 0x0 };
+
+static void caseDecoderEdge(suite_run *run){
+    resetSim();
+    abi_encoder_core<host_platform> dec(4000);
+    dec.setLevels(0, 0);
+
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < EDGE_OPS; i++) {
+        dec.edge(seq_channel[i & 3], seq_ab[i & 3] >> 1, seq_ab[i & 3] & 1);
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = 0;
+    run->ops = EDGE_OPS;
+    bench_sink = dec.getAmountSPR();
+}
+
+// Pin write -> host interrupt -> handler -> digitalRead -> edge(): includes the simulator
+static void caseDecoderInterrupt(suite_run *run){
+    resetSim();
+    host_sim::write(PIN_A, 0);
+    host_sim::write(PIN_B, 0);
+    abi_encoder_arduino dec(PIN_A, PIN_B);
+
+    static const int pins[2] = { PIN_A, PIN_B };
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < EDGE_OPS / 10; i++) {
+        host_sim::write(pins[seq_channel[i & 3]], seq_level[i & 3]);
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = 0;
+    run->ops = EDGE_OPS / 10;
+    bench_sink = dec.getAmountSPR();
+}
+
+// ---------------------------------------------------------------------------
+// Conversions and filters
+// ---------------------------------------------------------------------------
+
+template <class F>
+static void convert(suite_run *run, F fn){
+    int64_t acc = 0;
+    uint64_t start = bench_now_ns();
+    for (uint32_t r = 0; r < CONVERT_ROUNDS; r++) {
+        for (uint32_t i = 0; i < CONVERT_OPS; i++) {
+            acc += fn(raw_samples[i]);
+        }
+        bench_sink = acc;
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = 0;
+    run->ops = (uint64_t)CONVERT_ROUNDS * CONVERT_OPS;
+}
+
+struct to_deg { int64_t operator()(uint16_t raw) const { return (int64_t)(as5047p_raw_to_deg(raw) * 100.0f); } };
+struct to_centideg { int64_t operator()(uint16_t raw) const { return as5047p_raw_to_centideg(raw); } };
+struct to_q16 { int64_t operator()(uint16_t raw) const { return as5047p_raw_to_q16(raw); } };
+struct to_mrad { int64_t operator()(uint16_t raw) const { return as5047p_raw_to_mrad(raw); } };
+struct correct { int64_t operator()(uint16_t raw) const { return lut.apply(raw); } };
+
+static void caseAngleDeg(suite_run *run) { convert(run, to_deg()); }
+static void caseAngleCentideg(suite_run *run) { convert(run, to_centideg()); }
+static void caseAngleQ16(suite_run *run) { convert(run, to_q16()); }
+static void caseAngleMrad(suite_run *run) { convert(run, to_mrad()); }
+static void caseAngleCorrection(suite_run *run) { convert(run, correct()); }
+
+static void track(suite_run *run, alpha_beta_tracker &tracker){
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < FILTER_OPS; i++) {
+        tracker.update(filter_z[i], filter_t[i]);
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = 0;
+    run->ops = FILTER_OPS;
+    bench_sink = tracker.getPositionQ16();
+}
+
+static void caseTrackerAB(suite_run *run){
+    alpha_beta_tracker tracker(FILTER_PERIOD_US);
+    track(run, tracker);
+}
+
+static void caseTrackerABG(suite_run *run){
+    alpha_beta_tracker tracker(FILTER_PERIOD_US, 0, true);
+    track(run, tracker);
+}
+
+static void caseVelocity(suite_run *run){
+    mt_velocity velocity;
+    int64_t sum = 0;
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < FILTER_OPS; i++) {
+        sum += velocity.updateSnapshot(filter_z[i], filter_t[i]);
+    }
+    run->cpu_ns = bench_now_ns() - start;
+    run->bus_ns = 0;
+    run->ops = FILTER_OPS;
+    bench_sink = sum;
+}
+
+static const suite_case cases[] = {
+    { "ls7366r.sync",               caseCounterSync },
+    { "ls7366r.readStatus",         caseCounterStatus },
+    { "as5047p.frame",              caseSensorFrame },
+    { "as5047p.readAngle",          caseSensorAngle },
+    { "as5047p.readAnglePipelined", caseSensorPipelined },
+    { "as5047p.readAngleListen",    caseSensorListen },
+    { "as5047p.readSample",         caseSensorSample },
+    { "abi.edge",                   caseDecoderEdge },
+    { "abi.interrupt",              caseDecoderInterrupt },
+    { "angle.deg",                  caseAngleDeg },
+    { "angle.centideg",             caseAngleCentideg },
+    { "angle.q16",                  caseAngleQ16 },
+    { "angle.mrad",                 caseAngleMrad },
+    { "angle.correction",           caseAngleCorrection },
+    { "tracker.ab",                 caseTrackerAB },
+    { "tracker.abg",                caseTrackerABG },
+    { "mt_velocity.snapshot",       caseVelocity }
+};
+
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+// ---------------------------------------------------------------------------
+// Results and baselines
+// ---------------------------------------------------------------------------
+
+static void writeCsv(FILE *out, const suite_result *results, uint32_t count){
+    fprintf(out, "name,ops,cpu_ns,bus_ns\n");
+    for (uint32_t i = 0; i < count; i++) {
+        fprintf(out, "%s,%llu,%.3f,%.3f\n", results[i].name, (unsigned long long)results[i].ops,
+                results[i].cpu_ns, results[i].bus_ns);
+    }
+}
+
+/** Read a CSV written by writeCsv(), -1 if the file cannot be read */
+static int32_t readCsv(const char *path, suite_result *results, uint32_t max){
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        return -1;
+    }
+    char line[128];
+    uint32_t count = 0;
+    while (count < max && fgets(line, sizeof(line), in)) {
+        suite_result *r = &results[count];
+        char *comma = strchr(line, ',');
+        if (!comma || comma - line >= SUITE_NAME) {
+            continue;
+        }
+        unsigned long long ops;
+        if (sscanf(comma + 1, "%llu,%lf,%lf", &ops, &r->cpu_ns, &r->bus_ns) != 3) {
+            continue;   // Header
+        }
+        memcpy(r->name, line, comma - line);
+        r->name[comma - line] = 0;
+        r->ops = ops;
+        count++;
+    }
+    fclose(in);
+    return (int32_t)count;
+}
+
+static const suite_result *find(const suite_result *results, uint32_t count, const char *name){
+    for (uint32_t i = 0; i < count; i++) {
+        if (strcmp(results[i].name, name) == 0) {
+            return &results[i];
+        }
+    }
+    return 0;
+}
+
+static double percent(double before, double after){
+    return before > 0.0 ? (after - before) * 100.0 / before : 0.0;
+}
+
+/** Print the comparison, return the number of regressions */
+static uint32_t compare(const suite_result *base, uint32_t base_count,
+                        const suite_result *results, uint32_t count, double tolerance){
+    uint32_t regressions = 0;
+    printf("%-26s %10s %10s %8s %12s %12s\n", "case", "cpu before", "cpu after", "cpu %", "bus before", "bus after");
+    for (uint32_t i = 0; i < count; i++) {
+        const suite_result *now = &results[i];
+        const suite_result *old = find(base, base_count, now->name);
+        if (!old) {
+            printf("%-26s %10s %10.2f %8s %12s %12.1f  new\n", now->name, "-", now->cpu_ns, "-", "-", now->bus_ns);
+            continue;
+        }
+        double cpu_change = percent(old->cpu_ns, now->cpu_ns);
+        bool slower = cpu_change > tolerance || now->bus_ns > old->bus_ns + 0.5;
+        regressions += slower;
+        printf("%-26s %10.2f %10.2f %+7.1f%% %12.1f %12.1f%s\n", now->name, old->cpu_ns, now->cpu_ns,
+               cpu_change, old->bus_ns, now->bus_ns, slower ? "  SLOWER" : "");
+    }
+    for (uint32_t i = 0; i < base_count; i++) {
+        if (!find(results, count, base[i].name)) {
+            printf("%-26s  not run\n", base[i].name);
+        }
+    }
+    return regressions;
+}
+
+static void usage(){
+    fprintf(stderr, "usage: bench_suite [-c] [-s save.csv] [-b baseline.csv] [-t pct] [-r repeats] [-f filter]\n");
+}
+
+int main(int argc, char **argv){
+    bool csv = false;
+    const char *save_path = 0;
+    const char *base_path = 0;
+    const char *filter = 0;
+    double tolerance = 10.0;
+    uint32_t repeats = 5;
+
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        if (strcmp(opt, "-c") == 0) {
+            csv = true;
+        } else if (i + 1 < argc && strcmp(opt, "-s") == 0) {
+            save_path = argv[++i];
+        } else if (i + 1 < argc && strcmp(opt, "-b") == 0) {
+            base_path = argv[++i];
+        } else if (i + 1 < argc && strcmp(opt, "-t") == 0) {
+            tolerance = atof(argv[++i]);
+        } else if (i + 1 < argc && strcmp(opt, "-r") == 0) {
+            repeats = (uint32_t)atoi(argv[++i]);
+        } else if (i + 1 < argc && strcmp(opt, "-f") == 0) {
+            filter = argv[++i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (repeats == 0) {
+        repeats = 1;
+    }
+
+    static suite_result base[SUITE_CASES];
+    int32_t base_count = 0;
+    if (base_path) {
+        base_count = readCsv(base_path, base, SUITE_CASES);
+        if (base_count < 0) {
+            fprintf(stderr, "cannot read %s\n", base_path);
+            return 2;
+        }
+    }
+
+    makeInputs();
+
+    static suite_result results[SUITE_CASES];
+    uint32_t count = 0;
+    for (uint32_t c = 0; c < CASE_COUNT; c++) {
+        if (filter && !strstr(cases[c].name, filter)) {
+            continue;
+        }
+        // Fastest repeat: the least disturbed by the rest of the machine
+        suite_run best = suite_run();
+        for (uint32_t r = 0; r < repeats; r++) {
+            suite_run run = suite_run();
+            cases[c].fn(&run);
+            if (r == 0 || run.cpu_ns * best.ops < best.cpu_ns * run.ops) {
+                best = run;
+            }
+        }
+        suite_result *res = &results[count++];
+        snprintf(res->name, SUITE_NAME, "%s", cases[c].name);
+        res->ops = best.ops;
+        res->cpu_ns = best.ops ? (double)best.cpu_ns / best.ops : 0.0;
+        res->bus_ns = best.ops ? (double)best.bus_ns / best.ops : 0.0;
+        if (!csv && !base_path) {
+            printf("%-26s %10.2f ns/op cpu %12.1f ns/op bus\n", res->name, res->cpu_ns, res->bus_ns);
+        }
+    }
+
+    if (csv) {
+        writeCsv(stdout, results, count);
+    }
+    if (save_path) {
+        FILE *out = fopen(save_path, "w");
+        if (!out) {
+            fprintf(stderr, "cannot write %s\n", save_path);
+            return 2;
+        }
+        writeCsv(out, results, count);
+        fclose(out);
+    }
+    if (base_path) {
+        uint32_t regressions = compare(base, (uint32_t)base_count, results, count, tolerance);
+        printf("%u of %u cases slower than the baseline (cpu tolerance %.1f%%)\n", regressions, count, tolerance);
+        return regressions ? 1 : 0;
+    }
+    return 0;
+}
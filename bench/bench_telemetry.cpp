@@ -0,0 +1,124 @@
+/**
+ * @file bench_telemetry.cpp
+ * @brief Host benchmark: formatted text lines vs binary telemetry frames
+ *
+ * Streams BENCH_SAMPLES two-channel samples (2 kHz grid with jitter,
+ * encoders moving at a few hundred counts/s with reversals) both ways:
+ *
+ * - text:    the "Enc1: ... (STR=0x..) | Enc2: ..." line per sample (snprintf)
+ * - binary:  telemetry_encoder, FRAME_SAMPLES samples per frame
+ *
+ * and reports CPU per sample, bytes per sample and the highest sample
+ * rate that fits a 115200 baud UART (11520 bytes/s). The binary stream is
+ * decoded again and compared with the input.
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -I bench -I telemetry \
+ *       bench/bench_telemetry.cpp telemetry/telemetry.cpp -o bench_telemetry
+ *   ./bench_telemetry
+ */
+
+#include <stdio.h>
+#include "bench.h"
+#include "telemetry.h"
+
+#define BENCH_SAMPLES   200000
+#define FRAME_SAMPLES   20          // 10 ms of samples at 2 kHz
+#define UART_BYTES_S    11520
+
+static uint32_t sample_time[BENCH_SAMPLES];
+static int32_t sample_value[BENCH_SAMPLES][2];
+
+static uint32_t rng = 12345;
+
+static uint32_t nextRandom(){
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 8;
+}
+
+static void makeSamples(){
+    uint32_t t = 1000;
+    int32_t v1 = 0, v2 = 100000;
+    int32_t speed1 = 1, speed2 = -1;
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        t += 500 + (nextRandom() % 7) - 3;
+        if (nextRandom() % 2000 == 0) speed1 = -speed1;
+        if (nextRandom() % 3000 == 0) speed2 = -speed2;
+        v1 += speed1 * (int32_t)(nextRandom() % 3);
+        v2 += speed2 * (int32_t)(nextRandom() % 5);
+        sample_time[i] = t;
+        sample_value[i][0] = v1;
+        sample_value[i][1] = v2;
+    }
+}
+
+int main(){
+    makeSamples();
+
+    // Text
+    char line[96];
+    uint64_t text_bytes = 0;
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        int n = snprintf(line, sizeof(line), "Enc1: %ld (STR=0x%X) | Enc2: %ld (STR=0x%X) | samples %lu\r\n",
+                         (long)sample_value[i][0], 0x20u, (long)sample_value[i][1], 0x20u, (unsigned long)i);
+        text_bytes += n;
+        bench_sink += line[n - 3];
+    }
+    uint64_t text_ns = bench_now_ns() - start;
+
+    // Binary
+    static uint8_t stream[BENCH_SAMPLES * 8];
+    uint32_t stream_length = 0;
+    telemetry_encoder tx(2);
+    tx.setStatus(0, 0x20);
+    tx.setStatus(1, 0x20);
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        tx.addSample(sample_time[i], sample_value[i]);
+        if (tx.getSamples() == FRAME_SAMPLES) {
+            uint16_t n = tx.finish();
+            for (uint16_t k = 0; k < n; k++) {
+                stream[stream_length + k] = tx.getFrame()[k];
+            }
+            stream_length += n;
+        }
+    }
+    uint16_t n = tx.finish();
+    for (uint16_t k = 0; k < n; k++) {
+        stream[stream_length + k] = tx.getFrame()[k];
+    }
+    stream_length += n;
+    uint64_t binary_ns = bench_now_ns() - start;
+
+    // Decode and compare
+    static telemetry_decoder rx;
+    uint32_t decoded = 0, wrong = 0;
+    start = bench_now_ns();
+    for (uint32_t i = 0; i < stream_length; i++) {
+        if (!rx.push(stream[i]) || rx.getType() != TELEMETRY_SAMPLES) {
+            continue;
+        }
+        for (uint8_t s = 0; s < rx.getSamples(); s++, decoded++) {
+            if (rx.getTime(s) != sample_time[decoded] ||
+                rx.getValue(s, 0) != sample_value[decoded][0] ||
+                rx.getValue(s, 1) != sample_value[decoded][1]) {
+                wrong++;
+            }
+        }
+    }
+    uint64_t decode_ns = bench_now_ns() - start;
+    telemetry_decoder_stats stats;
+    rx.getStats(&stats);
+
+    double text_per = (double)text_bytes / BENCH_SAMPLES;
+    double binary_per = (double)stream_length / BENCH_SAMPLES;
+    bench_report("text line (snprintf)", text_ns, BENCH_SAMPLES);
+    bench_report("telemetry_encoder::addSample + finish", binary_ns, BENCH_SAMPLES);
+    bench_report("telemetry_decoder::push (per sample)", decode_ns, BENCH_SAMPLES);
+    printf("%-40s %8.2f bytes/sample, max %6.0f Hz at 115200\n", "text", text_per, UART_BYTES_S / text_per);
+    printf("%-40s %8.2f bytes/sample, max %6.0f Hz at 115200\n", "binary", binary_per, UART_BYTES_S / binary_per);
+    printf("decoded %u of %u samples, %u wrong, %u frames, %u lost, %u bad crc\n",
+           decoded, BENCH_SAMPLES, wrong, stats.frames, stats.lost, stats.bad_crc);
+    return 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file bench_trace.cpp
+ * @brief Host benchmark: bus trace recording cost, and a trace for trace_replay
+ *
+ * Runs LS7366R_Single and as5047p_core against the simulators with a
+ * bus_trace attached and reports the host CPU per call with and without
+ * recording (bus time is virtual and the same either way). Then records
+ * a mixed session, two counters, a full-duplex and a listen-only AS5047P,
+ * and writes the dump to the file given (default trace.bin) for
+ * tools/trace_replay.
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -DBUS_TRACE -DBUS_TRACE_RECORDS=4096 \
+ *       -I bench -I platform -I host -I host/arduino -I LS7366R -I as5047p -I bus \
+ *       bench/bench_trace.cpp host/host_sim.cpp host/quad_gen.cpp host/ls7366r_sim.cpp host/as5047p_sim.cpp \
+ *       host/arduino/host_arduino.cpp LS7366R/LS7366R_Single.cpp bus/bus_trace.cpp -o bench_trace
+ *   ./bench_trace trace.bin
+ */
+
+#include <stdio.h>
+#include "bench.h"
+#include "host_sim.h"
+#include "host_arduino.h"
+#include "platform_host.h"
+#include "ls7366r_sim.h"
+#include "as5047p_sim.h"
+#include "quad_gen.h"
+#include "LS7366R_Single.h"
+#include "as5047p_core.h"
+#include "bus_trace.h"
+
+#ifndef BUS_TRACE
+#error "build with -DBUS_TRACE"
+#endif
+
+#define PIN_A           32
+#define PIN_B           33
+#define PIN_CS_1        5
+#define PIN_CS_2        15
+#define PIN_CS_S        7
+#define PIN_MISO        19
+#define PIN_CLK         18
+#define PIN_MOSI        23
+#define PIN_CS_L        8
+#define PIN_MISO_L      20
+#define PIN_CLK_L       21
+
+#define BENCH_CALLS     20000
+#define SESSION_ROUNDS  300
+
+static void writeFile(void *ctx, const uint8_t *data, uint16_t len){
+    fwrite(data, 1, len, (FILE*)ctx);
+}
+
+static void benchOverhead(LS7366R_Single &counter, as5047p_core<host_platform> &sensor, bus_trace &trace){
+    static const char *names[2][2] = {
+        { "LS7366R_Single::sync (no trace)", "LS7366R_Single::sync (traced)" },
+        { "as5047p_core::readAngleRaw (no trace)", "as5047p_core::readAngleRaw (traced)" }
+    };
+    for (int traced = 0; traced < 2; traced++) {
+        counter.setTrace(traced ? &trace : 0);
+        sensor.setTrace(traced ? &trace : 0, PIN_CS_S);
+
+        uint64_t start = bench_now_ns();
+        for (uint32_t i = 0; i < BENCH_CALLS; i++) {
+            counter.sync();
+        }
+        bench_report(names[0][traced], bench_now_ns() - start, BENCH_CALLS);
+        bench_sink = counter.getCount();
+
+        start = bench_now_ns();
+        for (uint32_t i = 0; i < BENCH_CALLS; i++) {
+            bench_sink += sensor.readAngleRaw();
+        }
+        bench_report(names[1][traced], bench_now_ns() - start, BENCH_CALLS);
+    }
+}
+
+int main(int argc, char **argv){
+    const char *path = argc > 1 ? argv[1] : "trace.bin";
+
+    host_sim::reset();
+    host_arduino::reset();
+    quad_gen sig(PIN_A, PIN_B, -1, 3);
+    sig.setRate(50000);
+
+    ls7366r_sim chip1(PIN_CS_1, PIN_A, PIN_B);
+    ls7366r_sim chip2(PIN_CS_2, PIN_A, PIN_B);
+    as5047p_sim sim(PIN_CS_S, PIN_MISO, PIN_CLK, PIN_MOSI);
+    as5047p_sim sim_listen(PIN_CS_L, PIN_MISO_L, PIN_CLK_L, -1);
+    LS7366R_Single counter1(PIN_CS_1), counter2(PIN_CS_2);
+    as5047p_core<host_platform> sensor(PIN_CS_S, PIN_MISO, PIN_CLK, PIN_MOSI);
+    as5047p_core<host_platform> listener(PIN_CS_L, PIN_MISO_L, PIN_CLK_L, host_platform::NO_PIN);
+    counter1.begin();
+    counter2.begin();
+
+    static bus_trace trace;
+    benchOverhead(counter1, sensor, trace);
+
+    // Recorded session
+    trace.clear();
+    counter1.setTrace(&trace);
+    counter2.setTrace(&trace);
+    sensor.setTrace(&trace, PIN_CS_S);
+    listener.setTrace(&trace, PIN_CS_L);
+
+    sig.start();
+    counter1.reconfigure(LS7366R_MDR0_DEFAULT, LS7366R_MDR1_DEFAULT);
+    counter1.clearStatus();
+    as5047p_sample sample;
+    for (uint32_t round = 0; round < SESSION_ROUNDS; round++) {
+        sim.setAngle((uint16_t)(round * 37));
+        sim_listen.setAngle((uint16_t)(round * 53));
+        counter1.sync();
+        counter2.sync();
+        sensor.readSample(&sample);
+        uint16_t angle;
+        sensor.readAngleRawPipelined(&angle);   // Primes the pipeline after readSample()
+        sensor.readAngleRawPipelined(&angle);   // One frame
+        sensor.readAngleRaw();
+        listener.readAngleRaw();
+        if (round % 10 == 0) {
+            counter1.readStatus();
+            sensor.readDiagnostics();
+        }
+        if (round % 100 == 50) {
+            counter2.reset();
+            counter2.disable();
+            counter2.enable();
+            sensor.writeRegister(AS5047P_REG_ZPOSL, round & 0x3F);
+        }
+        host_sim::advance(100000);
+    }
+    sig.stop();
+    trace.stop();
+
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return 1;
+    }
+    uint16_t records = trace.dump(writeFile, out);
+    long bytes = ftell(out);
+    fclose(out);
+    printf("recorded %u frames, dumped %u records, %ld bytes (%.1f bytes/record) to %s\n",
+           trace.getRecorded(), records, bytes, (double)bytes / records, path);
+    return 0;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file bench_tracker.cpp
+ * @brief Host benchmark: alpha_beta_tracker cost per update
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -I motion bench/bench_tracker.cpp motion/alpha_beta_tracker.cpp -o bench_tracker
+ *   ./bench_tracker
+ */
+
+#include "bench.h"
+#include "alpha_beta_tracker.h"
+
+#define BENCH_SAMPLES   10000000
+#define BENCH_PERIOD_US 100         // 10 kHz
+
+// Deterministic noisy ramp: 20000 counts/s with +/-2 counts of noise
+static void makeSamples(int64_t *z, uint32_t *t, uint32_t n, uint32_t wrap_mask){
+    uint32_t rng = 12345;
+    for (uint32_t i = 0; i < n; i++) {
+        rng = rng * 1664525u + 1013904223u;
+        int64_t pos = (int64_t)i * 2 + (int64_t)((rng >> 24) % 5) - 2;
+        z[i] = wrap_mask ? (pos & wrap_mask) : pos;
+        t[i] = i * BENCH_PERIOD_US + ((rng >> 8) & 3);   // a little jitter
+    }
+}
+
+static void run(const char *name, alpha_beta_tracker &tracker, const int64_t *z, const uint32_t *t, uint32_t n){
+    uint64_t start = bench_now_ns();
+    for (uint32_t i = 0; i < n; i++) {
+        tracker.update(z[i], t[i]);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_sink = tracker.getPositionQ16();
+    bench_report(name, elapsed, n);
+    printf("%-40s %8.1f counts/s (true 20000.0)\n", "  velocity", tracker.getVelocity() / 256.0);
+}
+
+int main(){
+    static int64_t z[BENCH_SAMPLES];
+    static uint32_t t[BENCH_SAMPLES];
+
+    makeSamples(z, t, BENCH_SAMPLES, 0);
+
+    alpha_beta_tracker ab(BENCH_PERIOD_US);
+    run("alpha_beta_tracker::update (ab)", ab, z, t, BENCH_SAMPLES);
+
+    alpha_beta_tracker abg(BENCH_PERIOD_US, 0, true);
+    run("alpha_beta_tracker::update (abg)", abg, z, t, BENCH_SAMPLES);
+
+    makeSamples(z, t, BENCH_SAMPLES, 0x3FFF);
+
+    alpha_beta_tracker wrapped(BENCH_PERIOD_US, 14);
+    run("alpha_beta_tracker::update (14-bit wrap)", wrapped, z, t, BENCH_SAMPLES);
+
+    return 0;
+}
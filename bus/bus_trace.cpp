@@ -0,0 +1,174 @@
+/**
+ * @file bus_trace.cpp
+ * @brief Implementation of bus transaction recorder
+ */
+
+#include "bus_trace.h"
+
+static uint8_t putVarint(uint8_t *p, uint32_t v){
+    uint8_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static bool getVarint(const uint8_t *p, uint32_t len, uint32_t *pos, uint32_t *v){
+    uint32_t result = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (*pos >= len) {
+            return false;
+        }
+        uint8_t b = p[(*pos)++];
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+bus_trace::bus_trace() : next(0), recording(1) {
+    static_assert((BUS_TRACE_RECORDS & (BUS_TRACE_RECORDS - 1)) == 0,
+                  "BUS_TRACE_RECORDS must be a power of two");
+    for (uint32_t i = 0; i < BUS_TRACE_RECORDS; i++) {
+        records[i].done = 0;
+    }
+}
+
+bus_trace_record *bus_trace::beginFrame(uint8_t device, uint8_t kind, uint32_t now_us){
+    if (!__atomic_load_n(&recording, __ATOMIC_RELAXED)) {
+        return 0;
+    }
+    uint32_t i = __atomic_fetch_add(&next, 1, __ATOMIC_ACQ_REL);
+    bus_trace_record *rec = &records[i & (BUS_TRACE_RECORDS - 1)];
+    __atomic_store_n(&rec->done, 0, __ATOMIC_RELAXED);
+    rec->time_us = now_us;
+    rec->duration_us = 0;
+    rec->device = device;
+    rec->kind = kind;
+    rec->length = 0;
+    return rec;
+}
+
+void bus_trace::start(){
+    __atomic_store_n(&recording, 1, __ATOMIC_RELEASE);
+}
+
+void bus_trace::stop(){
+    __atomic_store_n(&recording, 0, __ATOMIC_RELEASE);
+}
+
+void bus_trace::clear(){
+    for (uint32_t i = 0; i < BUS_TRACE_RECORDS; i++) {
+        __atomic_store_n(&records[i].done, 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&next, 0, __ATOMIC_RELEASE);
+}
+
+uint16_t bus_trace::dump(bus_trace_writer fn, void *ctx) const{
+    uint32_t end = __atomic_load_n(&next, __ATOMIC_ACQUIRE);
+    uint32_t first = end > BUS_TRACE_RECORDS ? end - BUS_TRACE_RECORDS : 0;
+
+    // Take the finished set once: a frame that ends meanwhile must not
+    // be written without being in the header count
+    uint32_t done[(BUS_TRACE_RECORDS + 31) / 32];
+    uint16_t count = 0;
+    uint32_t first_us = 0;
+    for (uint32_t i = first; i < end; i++) {
+        uint32_t slot = i & (BUS_TRACE_RECORDS - 1);
+        const bus_trace_record &r = records[slot];
+        if (__atomic_load_n(&r.done, __ATOMIC_ACQUIRE)) {
+            if (!count) {
+                first_us = r.time_us;
+            }
+            count++;
+            done[slot / 32] |= (uint32_t)1 << (slot % 32);
+        } else {
+            done[slot / 32] &= ~((uint32_t)1 << (slot % 32));
+        }
+    }
+
+    uint8_t buf[2 * 5 + 3 + 2 * BUS_TRACE_BYTES];
+    buf[0] = 'B';
+    buf[1] = 'T';
+    buf[2] = 'R';
+    buf[3] = 'C';
+    buf[4] = BUS_TRACE_VERSION;
+    buf[5] = (uint8_t)count;
+    buf[6] = (uint8_t)(count >> 8);
+    buf[7] = (uint8_t)first_us;
+    buf[8] = (uint8_t)(first_us >> 8);
+    buf[9] = (uint8_t)(first_us >> 16);
+    buf[10] = (uint8_t)(first_us >> 24);
+    fn(ctx, buf, 11);
+
+    uint32_t last_us = first_us;
+    for (uint32_t i = first; i < end; i++) {
+        uint32_t slot = i & (BUS_TRACE_RECORDS - 1);
+        if (!(done[slot / 32] & ((uint32_t)1 << (slot % 32)))) {
+            continue;
+        }
+        const bus_trace_record &r = records[slot];
+        uint8_t n = 0;
+        n += putVarint(&buf[n], r.time_us - last_us);
+        n += putVarint(&buf[n], r.duration_us);
+        buf[n++] = r.device;
+        buf[n++] = r.kind;
+        buf[n++] = r.length;
+        uint8_t stored = r.length < BUS_TRACE_BYTES ? r.length : BUS_TRACE_BYTES;
+        for (uint8_t k = 0; k < stored; k++) {
+            buf[n++] = r.out[k];
+        }
+        for (uint8_t k = 0; k < stored; k++) {
+            buf[n++] = r.in[k];
+        }
+        fn(ctx, buf, n);
+        last_us = r.time_us;
+    }
+    return count;
+}
+
+int32_t bus_trace_parse(const uint8_t *data, uint32_t len, bus_trace_record *out, uint32_t max){
+    if (len < 11 || data[0] != 'B' || data[1] != 'T' || data[2] != 'R' || data[3] != 'C' ||
+        data[4] != BUS_TRACE_VERSION) {
+        return -1;
+    }
+    uint32_t count = (uint32_t)data[5] | ((uint32_t)data[6] << 8);
+    uint32_t time_us = (uint32_t)data[7] | ((uint32_t)data[8] << 8) |
+                       ((uint32_t)data[9] << 16) | ((uint32_t)data[10] << 24);
+    if (count > max) {
+        return -1;
+    }
+
+    uint32_t pos = 11;
+    for (uint32_t i = 0; i < count; i++) {
+        bus_trace_record &r = out[i];
+        uint32_t delta, duration;
+        if (!getVarint(data, len, &pos, &delta) || !getVarint(data, len, &pos, &duration) ||
+            pos + 3 > len) {
+            return -1;
+        }
+        time_us += delta;
+        r.time_us = time_us;
+        r.duration_us = duration > 0xFFFF ? 0xFFFF : (uint16_t)duration;
+        r.device = data[pos++];
+        r.kind = data[pos++];
+        r.length = data[pos++];
+        r.done = 1;
+        uint8_t stored = r.length < BUS_TRACE_BYTES ? r.length : BUS_TRACE_BYTES;
+        if (pos + 2u * stored > len) {
+            return -1;
+        }
+        for (uint8_t k = 0; k < stored; k++) {
+            r.out[k] = data[pos++];
+        }
+        for (uint8_t k = 0; k < stored; k++) {
+            r.in[k] = data[pos++];
+        }
+    }
+    return (int32_t)count;
+}
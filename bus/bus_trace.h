@@ -0,0 +1,132 @@
+/**
+ * @file bus_trace.h
+ * @brief Bus transaction recorder: one record per CS frame, compact binary dump
+ *
+ * Built with -DBUS_TRACE, LS7366R_Single and as5047p_core take a
+ * bus_trace with setTrace() and record every CS frame they run: when CS
+ * went low, how long it stayed low, the device (CS pin), and the bytes
+ * sent and received. Without BUS_TRACE the drivers contain no trace code.
+ *
+ * Records go into a fixed ring of BUS_TRACE_RECORDS; when it is full the
+ * oldest are overwritten, so the trace always holds the latest history.
+ * Claiming a record is one atomic add, so drivers used from different
+ * contexts can share one trace.
+ *
+ *   bus_trace trace;
+ *   encoder1.setTrace(&trace);
+ *   ...
+ *   trace.stop();               // then dump once the bus is idle
+ *   trace.dump(writeBytes, 0);
+ *
+ * Dump format (little endian):
+ *
+ *   "BTRC"  version (u8)  records (u16)  time_us of the first record (u32)
+ *   per record:  varint(start - previous start)  varint(duration_us)
+ *                device (u8)  kind (u8)  length (u8)  out[n]  in[n]
+ *
+ * where n = min(length, BUS_TRACE_BYTES). bus_trace_parse() reads it back
+ * (host tools: tools/trace_replay).
+ */
+
+#ifndef _BUS_TRACE_H
+#define _BUS_TRACE_H
+
+#include <stdint.h>
+
+/** Records kept (power of two) */
+#ifndef BUS_TRACE_RECORDS
+#define BUS_TRACE_RECORDS       256
+#endif
+
+/** Bytes kept per direction and frame (longer frames are truncated) */
+#define BUS_TRACE_BYTES         6
+
+#define BUS_TRACE_VERSION       1
+
+/** bus_trace_record::kind */
+#define BUS_TRACE_LS7366R       0x01    ///< LS7366R_Single, hardware SPI, one byte per transfer
+#define BUS_TRACE_AS5047P       0x02    ///< as5047p_core, bit-banged 16-bit frames (MSB first)
+#define BUS_TRACE_NO_MOSI       0x80    ///< Flag: listen-only frame, out[] not driven
+
+/** One CS frame */
+struct bus_trace_record{
+    uint32_t time_us;                   ///< CS low
+    uint16_t duration_us;               ///< CS low to CS high
+    uint8_t device;                     ///< CS pin
+    uint8_t kind;                       ///< BUS_TRACE_xxx
+    uint8_t length;                     ///< Bytes exchanged (saturates at 255)
+    uint8_t done;                       ///< 1 once the frame ended
+    uint8_t out[BUS_TRACE_BYTES];       ///< MOSI
+    uint8_t in[BUS_TRACE_BYTES];        ///< MISO
+};
+
+/** Receives the dump bytes */
+typedef void (*bus_trace_writer)(void *ctx, const uint8_t *data, uint16_t len);
+
+class bus_trace{
+    private:
+        bus_trace_record records[BUS_TRACE_RECORDS];
+        uint32_t next;          // Records claimed so far
+        uint8_t recording;
+
+    public:
+        bus_trace();
+
+        /** Start a frame (CS going low)
+         *
+         *  @return     Record to fill, 0 while stopped
+         */
+        bus_trace_record *beginFrame(uint8_t device, uint8_t kind, uint32_t now_us);
+
+        /** Add one exchanged byte */
+        static void put(bus_trace_record *rec, uint8_t out, uint8_t in){
+            if (rec->length < BUS_TRACE_BYTES) {
+                rec->out[rec->length] = out;
+                rec->in[rec->length] = in;
+            }
+            if (rec->length < 0xFF) {
+                rec->length++;
+            }
+        }
+
+        /** End a frame (CS going high) */
+        static void endFrame(bus_trace_record *rec, uint32_t now_us){
+            uint32_t d = now_us - rec->time_us;
+            rec->duration_us = d > 0xFFFF ? 0xFFFF : (uint16_t)d;
+            __atomic_store_n(&rec->done, 1, __ATOMIC_RELEASE);
+        }
+
+        /** Start / stop recording (stopping keeps the records) */
+        void start();
+        void stop();
+
+        /** Drop all records */
+        void clear();
+
+        /** Frames recorded since construction or clear() (may exceed the ring) */
+        uint32_t getRecorded() const { return __atomic_load_n(&next, __ATOMIC_ACQUIRE); }
+
+        /** Write the finished records, oldest first
+         *
+         *  Call after stop(), once the frames in flight have ended. The
+         *  finished set is taken once, so a frame that ends during the
+         *  dump is left out rather than miscounted.
+         *
+         *  @param fn   Byte sink
+         *  @param ctx  Passed back to fn
+         *  @return     Records written
+         */
+        uint16_t dump(bus_trace_writer fn, void *ctx) const;
+};
+
+/** Read a dump back
+ *
+ *  @param data     Dump
+ *  @param len      Dump length
+ *  @param out      Records (device, kind, times, bytes; done = 1)
+ *  @param max      Room in out
+ *  @return         Records read, -1 if the dump is malformed
+ */
+int32_t bus_trace_parse(const uint8_t *data, uint32_t len, bus_trace_record *out, uint32_t max);
+
+#endif
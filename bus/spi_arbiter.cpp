@@ -0,0 +1,192 @@
+/**
+ * @file spi_arbiter.cpp
+ * @brief Implementation of the shared SPI bus arbiter
+ */
+
+#include "spi_arbiter.h"
+
+static bool sameSettings(const spi_bus_settings *a, const spi_bus_settings *b){
+    if (a == b) {
+        return true;
+    }
+    return a && b && a->clock == b->clock && a->bit_order == b->bit_order && a->mode == b->mode;
+}
+
+// Wrap-safe: true if a is before b
+static bool before(uint32_t a, uint32_t b){
+    return (int32_t)(a - b) < 0;
+}
+
+spi_arbiter::spi_arbiter(SPIClass &spi, uint32_t group_slack_us)
+    : spi(spi), group_slack_us(group_slack_us), owned(0), open(0) {
+    for (int i = 0; i < SPI_ARBITER_SLOTS; i++) {
+        slots[i] = 0;
+    }
+    resetStats();
+}
+
+void spi_arbiter::resetStats(){
+    stats.transactions = 0;
+    stats.groups = 0;
+    stats.late = 0;
+    stats.max_late_us = 0;
+    stats.full = 0;
+    stats.max_depth = 0;
+}
+
+bool spi_arbiter::tryAcquire(){
+    uint8_t expected = 0;
+    return __atomic_compare_exchange_n(&owned, &expected, 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+void spi_arbiter::release(){
+    __atomic_store_n(&owned, 0, __ATOMIC_SEQ_CST);
+}
+
+bool spi_arbiter::anyQueued() const{
+    for (int i = 0; i < SPI_ARBITER_SLOTS; i++) {
+        if (__atomic_load_n(&slots[i], __ATOMIC_SEQ_CST)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int spi_arbiter::pick(uint32_t now){
+    int best = -1;
+    int group = -1;     // Best one that fits the open settings
+    uint8_t depth = 0;
+
+    for (int i = 0; i < SPI_ARBITER_SLOTS; i++) {
+        spi_transaction *t = __atomic_load_n(&slots[i], __ATOMIC_ACQUIRE);
+        if (!t) {
+            continue;
+        }
+        depth++;
+        if (best < 0 || t->priority > slots[best]->priority ||
+            (t->priority == slots[best]->priority && before(t->deadline_us, slots[best]->deadline_us))) {
+            best = i;
+        }
+        if (open && sameSettings(t->settings, open) &&
+            (group < 0 || t->priority > slots[group]->priority ||
+             (t->priority == slots[group]->priority && before(t->deadline_us, slots[group]->deadline_us)))) {
+            group = i;
+        }
+    }
+
+    if (depth > stats.max_depth) {
+        stats.max_depth = depth;
+    }
+
+    // Stay in the open group while the most urgent one (same priority) can wait
+    if (group >= 0 && group != best &&
+        slots[group]->priority == slots[best]->priority &&
+        !before(slots[best]->deadline_us, now + group_slack_us)) {
+        return group;
+    }
+    return best;
+}
+
+void spi_arbiter::openGroup(const spi_bus_settings *settings){
+    spi.beginTransaction(SPISettings(settings->clock, settings->bit_order, settings->mode));
+    open = settings;
+    stats.groups++;
+}
+
+void spi_arbiter::closeGroup(){
+    if (open) {
+        spi.endTransaction();
+        open = 0;
+    }
+}
+
+void spi_arbiter::execute(spi_transaction *t, uint32_t now){
+    if (!t->settings) {
+        closeGroup();
+    } else if (!sameSettings(t->settings, open)) {
+        closeGroup();
+        openGroup(t->settings);
+    }
+
+    t->start_us = now;
+    int32_t late = (int32_t)(now - t->deadline_us);
+    if (late > 0) {
+        stats.late++;
+        if ((uint32_t)late > stats.max_late_us) {
+            stats.max_late_us = late;
+        }
+    }
+
+    t->fn(t->ctx);
+    stats.transactions++;
+    __atomic_store_n(&t->state, (uint8_t)SPI_TRANSACTION_DONE, __ATOMIC_RELEASE);
+}
+
+void spi_arbiter::drain(){
+    for (;;) {
+        uint32_t now = micros();
+        int i = pick(now);
+        if (i < 0) {
+            break;
+        }
+        spi_transaction *t = slots[i];
+        __atomic_store_n(&slots[i], (spi_transaction*)0, __ATOMIC_SEQ_CST);
+        execute(t, now);
+    }
+    closeGroup();
+}
+
+bool spi_arbiter::service(){
+    // A transaction queued just before release() is picked up by the re-check
+    do {
+        if (!tryAcquire()) {
+            return false;
+        }
+        drain();
+        release();
+    } while (anyQueued());
+    return true;
+}
+
+bool spi_arbiter::post(spi_transaction *t, uint32_t budget_us){
+    if (__atomic_load_n(&t->state, __ATOMIC_ACQUIRE) == SPI_TRANSACTION_QUEUED) {
+        return false;
+    }
+    t->deadline_us = micros() + budget_us;
+    __atomic_store_n(&t->state, (uint8_t)SPI_TRANSACTION_QUEUED, __ATOMIC_RELEASE);
+
+    bool queued = false;
+    for (int i = 0; i < SPI_ARBITER_SLOTS && !queued; i++) {
+        spi_transaction *expected = 0;
+        queued = __atomic_compare_exchange_n(&slots[i], &expected, t, false,
+                                             __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+    if (!queued) {
+        __atomic_store_n(&t->state, (uint8_t)SPI_TRANSACTION_IDLE, __ATOMIC_RELEASE);
+        __atomic_fetch_add(&stats.full, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    return true;
+}
+
+bool spi_arbiter::submit(spi_transaction *t, uint32_t budget_us){
+    if (!post(t, budget_us)) {
+        return false;
+    }
+    service();
+    return true;
+}
+
+void spi_arbiter::finish(spi_transaction *t){
+    while (!isDone(t)) {
+        service();
+    }
+}
+
+bool spi_arbiter::run(spi_transaction *t, uint32_t budget_us){
+    if (!submit(t, budget_us)) {
+        return false;
+    }
+    finish(t);
+    return true;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file spi_arbiter.h
+ * @brief Shared SPI bus arbiter: priority / deadline queue with settings grouping
+ *
+ * Devices on one SPI bus (several LS7366R_Single, other sensors) are
+ * accessed from different contexts: a timer sampler, loop(), a command
+ * handler. Instead of calling SPI.beginTransaction() themselves they
+ * hand spi_arbiter a spi_transaction (a function that does the CS /
+ * transfer work) and the arbiter runs them one at a time:
+ *
+ * - highest priority first, then earliest deadline
+ * - transactions with the same settings as the open one run inside the
+ *   same SPI.beginTransaction() when the others can wait (group slack),
+ *   so the bus is reconfigured only when the device type changes
+ *
+ * No lock is held per byte or per transaction. Submitting takes a free
+ * queue slot with one compare-and-swap; whoever finds the bus free
+ * becomes its owner and runs everything queued, including transactions
+ * submitted meanwhile by contexts that preempted it. A preempting
+ * context therefore never waits for the owner: submit() returns at once
+ * and the transaction runs as soon as the owner's current one ends.
+ *
+ *   static spi_bus_settings ls7366r = { LS7366R_SPI_SPEED, LS7366R_SPI_BITORDER, LS7366R_SPI_MODE };
+ *   encoder1.setExternalTransaction(true);
+ *   spi_transaction t(syncEncoder1, 0, &ls7366r, 2);
+ *   arbiter.run(&t);
+ */
+
+#ifndef _SPI_ARBITER_H
+#define _SPI_ARBITER_H
+
+#include <Arduino.h>
+#include <SPI.h>
+
+/** Queue slots (transactions waiting at the same time) */
+#define SPI_ARBITER_SLOTS           8
+
+/** Default time a group may make other transactions wait (us) */
+#define SPI_ARBITER_GROUP_SLACK     200
+
+/** Priorities (any uint8_t works; higher runs first) */
+#define SPI_PRIORITY_LOW            0
+#define SPI_PRIORITY_NORMAL         1
+#define SPI_PRIORITY_HIGH           2
+
+/** spi_transaction::state */
+#define SPI_TRANSACTION_IDLE        0
+#define SPI_TRANSACTION_QUEUED      1
+#define SPI_TRANSACTION_DONE        2
+
+/** Bus configuration of one device type */
+struct spi_bus_settings{
+    uint32_t clock;
+    uint8_t bit_order;
+    uint8_t mode;
+};
+
+/** Bus work, run by whichever context owns the bus */
+typedef void (*spi_transaction_fn)(void *ctx);
+
+/** One queued access; owned by the caller until it is done */
+struct spi_transaction{
+    spi_transaction_fn fn;
+    void *ctx;
+    const spi_bus_settings *settings;   ///< 0: runs outside any SPI transaction (bit-banged devices)
+    uint8_t priority;
+    uint32_t deadline_us;               ///< micros() by which it should start (set by submit())
+    uint32_t start_us;                  ///< When it started (valid once done)
+    uint8_t state;
+
+    spi_transaction(spi_transaction_fn fn = 0, void *ctx = 0,
+                    const spi_bus_settings *settings = 0, uint8_t priority = SPI_PRIORITY_NORMAL)
+        : fn(fn), ctx(ctx), settings(settings), priority(priority),
+          deadline_us(0), start_us(0), state(SPI_TRANSACTION_IDLE) {}
+};
+
+/** Statistics since construction or resetStats() */
+struct spi_arbiter_stats{
+    uint32_t transactions;      ///< Transactions run
+    uint32_t groups;            ///< SPI.beginTransaction() calls
+    uint32_t late;              ///< Transactions started after their deadline
+    uint32_t max_late_us;       ///< Worst lateness
+    uint32_t full;              ///< submit() calls refused (no free slot)
+    uint8_t max_depth;          ///< Most transactions queued at once
+};
+
+class spi_arbiter{
+    private:
+        SPIClass &spi;
+        uint32_t group_slack_us;
+
+        spi_transaction *slots[SPI_ARBITER_SLOTS];  // 0 = free
+        uint8_t owned;                              // 1 while a context runs the queue
+
+        // Owner only
+        const spi_bus_settings *open;               // Settings of the open SPI transaction
+        spi_arbiter_stats stats;
+
+        bool tryAcquire();
+        void release();
+        bool anyQueued() const;
+        int pick(uint32_t now);
+        void execute(spi_transaction *t, uint32_t now);
+        void openGroup(const spi_bus_settings *settings);
+        void closeGroup();
+        void drain();
+
+    public:
+        /** Creates spi_arbiter object with specific content.
+         *
+         *  @param spi              Bus (SPI.begin() is left to the caller)
+         *  @param group_slack_us   How long same-settings transactions may
+         *                          delay a more urgent one with other settings
+         */
+        spi_arbiter(SPIClass &spi = SPI, uint32_t group_slack_us = SPI_ARBITER_GROUP_SLACK);
+
+        /** Queue a transaction without running the queue
+         *
+         *  Lets a batch be ordered and grouped as a whole; run it with
+         *  service() or finish().
+         *
+         *  @param t            Transaction (not queued already)
+         *  @param budget_us    Deadline relative to now
+         *  @return             false if the queue is full or t is queued
+         */
+        bool post(spi_transaction *t, uint32_t budget_us = 0);
+
+        /** Queue a transaction without waiting
+         *
+         *  Runs it at once if the bus is free. Otherwise the current owner
+         *  runs it; poll isDone() or wait with finish().
+         *
+         *  @param t            Transaction (not queued already)
+         *  @param budget_us    Deadline relative to now
+         *  @return             false if the queue is full or t is queued
+         */
+        bool submit(spi_transaction *t, uint32_t budget_us = 0);
+
+        /** Queue a transaction and wait until it ran
+         *
+         *  Waiting spins, so from a context that can preempt the bus owner
+         *  on the same core (interrupt, higher-priority task) use submit().
+         *
+         *  @param t            Transaction
+         *  @param budget_us    Deadline relative to now
+         *  @return             false if it could not be queued
+         */
+        bool run(spi_transaction *t, uint32_t budget_us = 0);
+
+        /** Wait for a submitted transaction
+         *
+         *  @param t    Transaction
+         */
+        void finish(spi_transaction *t);
+
+        /** true once the transaction ran (it may then be reused) */
+        bool isDone(const spi_transaction *t) const{
+            return __atomic_load_n(&t->state, __ATOMIC_ACQUIRE) == SPI_TRANSACTION_DONE;
+        }
+
+        /** Run queued transactions if the bus is free
+         *
+         *  @return     false if another context owns the bus
+         */
+        bool service();
+
+        /** Get the statistics (values may straddle a running drain) */
+        void getStats(spi_arbiter_stats *out) const { *out = stats; }
+
+        /** Restart the statistics */
+        void resetStats();
+};
+
+#endif
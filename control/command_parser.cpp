@@ -0,0 +1,128 @@
+/**
+ * @file command_parser.cpp
+ * @brief Implementation of incremental serial command parser
+ */
+
+#include "command_parser.h"
+
+static bool isTerminator(char c){
+    return c == '\r' || c == '\n' || c == ';';
+}
+
+static bool isSeparator(char c){
+    return c == ' ' || c == '\t' || c == ',';
+}
+
+static int8_t digitValue(char c, bool hex){
+    if (c >= '0' && c <= '9') return c - '0';
+    if (!hex) return -1;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+command_parser::command_parser()
+    : pending(COMMAND_NONE), args(0), digits(0), hex(false), bad(false), errors(0) {
+}
+
+void command_parser::start(command_type type){
+    pending = type;
+    args = 0;
+    digits = 0;
+    hex = false;
+    bad = false;
+    for (uint8_t i = 0; i < COMMAND_MAX_ARGS; i++) {
+        arg[i] = 0;
+    }
+}
+
+bool command_parser::complete(serial_command *out){
+    command_type type = pending;
+    pending = COMMAND_NONE;
+
+    if (digits) {
+        args++;
+    }
+    uint8_t needed = type == COMMAND_RECONFIGURE ? 3 : 1;
+    if (bad || args != needed || (type == COMMAND_SET_RATE && arg[0] == 0)) {
+        errors++;
+        return false;
+    }
+
+    out->type = type;
+    for (uint8_t i = 0; i < COMMAND_MAX_ARGS; i++) {
+        out->arg[i] = arg[i];
+    }
+    return true;
+}
+
+bool command_parser::push(char c, serial_command *out){
+    if (pending == COMMAND_NONE) {
+        if (isTerminator(c) || isSeparator(c)) {
+            return false;
+        }
+        switch (c) {
+            case 'z': case 'Z':
+            case '1':
+            case '2':
+                out->type = COMMAND_RESET;
+                out->arg[0] = c == '1' ? 0x1 : c == '2' ? 0x2 : 0x3;
+                out->arg[1] = out->arg[2] = 0;
+                return true;
+            case 'r': case 'R':
+                out->type = COMMAND_READ;
+                out->arg[0] = out->arg[1] = out->arg[2] = 0;
+                return true;
+            case 'p': case 'P':
+                out->type = COMMAND_PROFILE;
+                out->arg[0] = out->arg[1] = out->arg[2] = 0;
+                return true;
+            case 's': case 'S':
+                start(COMMAND_SET_RATE);
+                return false;
+            case 'c': case 'C':
+                start(COMMAND_RECONFIGURE);
+                return false;
+            case 't': case 'T':
+                start(COMMAND_CAPTURE);
+                return false;
+        }
+        errors++;
+        return false;
+    }
+
+    if (isTerminator(c)) {
+        return complete(out);
+    }
+    if (bad) {
+        return false;
+    }
+
+    if (isSeparator(c)) {
+        if (digits) {
+            args++;
+            digits = 0;
+            hex = false;
+        }
+        return false;
+    }
+
+    if ((c == 'x' || c == 'X') && digits == 1 && !hex && arg[args] == 0) {
+        hex = true;
+        return false;
+    }
+
+    int8_t d = digitValue(c, hex);
+    if (d < 0 || args >= COMMAND_MAX_ARGS) {
+        bad = true;
+        return false;
+    }
+    uint32_t base = hex ? 16 : 10;
+    if (arg[args] > (0xFFFFFFFFu - (uint32_t)d) / base) {
+        bad = true;
+        return false;
+    }
+    arg[args] = arg[args] * base + (uint32_t)d;
+    digits++;
+    return false;
+}
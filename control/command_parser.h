@@ -0,0 +1,79 @@
+/**
+ * @file command_parser.h
+ * @brief Incremental parser for single-letter serial commands
+ *
+ * Bytes are fed one at a time as they arrive (no line buffer, no
+ * blocking); a command is returned as soon as it is complete:
+ *
+ *   z               reset both encoders          COMMAND_RESET, arg[0] = 0x3
+ *   1 / 2           reset encoder 1 / 2          COMMAND_RESET, arg[0] = 0x1 / 0x2
+ *   r               read the counts              COMMAND_READ
+ *   s <hz>          set the sample rate          COMMAND_SET_RATE, arg[0] = hz
+ *   c <m> <0> <1>   reconfigure encoders m       COMMAND_RECONFIGURE, arg = mask, MDR0, MDR1
+ *   t <n>           stream the next n samples    COMMAND_CAPTURE, arg[0] = n (0: stream all)
+ *   p               report the call profile      COMMAND_PROFILE
+ *
+ * Letters are case-insensitive. Commands without arguments take effect
+ * on the letter itself, so the single keys of the Arduino serial monitor
+ * keep working; commands with arguments end with CR, LF or ';'. Numbers
+ * are decimal or 0x-prefixed hex, separated by spaces or commas. A
+ * malformed command is dropped up to its terminator and counted.
+ *
+ *   serial_command cmd;
+ *   while (Serial.available()) {
+ *       if (parser.push(Serial.read(), &cmd)) { ... }
+ *   }
+ */
+
+#ifndef _COMMAND_PARSER_H
+#define _COMMAND_PARSER_H
+
+#include <stdint.h>
+
+/** Arguments per command */
+#define COMMAND_MAX_ARGS    3
+
+enum command_type{
+    COMMAND_NONE = 0,
+    COMMAND_RESET,              ///< arg[0]: encoder mask (bit 0 = encoder 1)
+    COMMAND_READ,
+    COMMAND_SET_RATE,           ///< arg[0]: rate (Hz)
+    COMMAND_RECONFIGURE,        ///< arg[0]: encoder mask, arg[1]: MDR0, arg[2]: MDR1
+    COMMAND_CAPTURE,            ///< arg[0]: samples to stream, 0 for all
+    COMMAND_PROFILE
+};
+
+struct serial_command{
+    command_type type;
+    uint32_t arg[COMMAND_MAX_ARGS];
+};
+
+class command_parser{
+    private:
+        command_type pending;       // Command collecting arguments, NONE when idle
+        uint32_t arg[COMMAND_MAX_ARGS];
+        uint8_t args;               // Arguments complete so far
+        uint8_t digits;             // Digits in the current argument
+        bool hex;
+        bool bad;                   // Drop up to the terminator
+        uint32_t errors;
+
+        void start(command_type type);
+        bool complete(serial_command *out);
+
+    public:
+        command_parser();
+
+        /** Feed one received byte
+         *
+         *  @param c    Byte
+         *  @param out  Command, set when true is returned
+         *  @return     true if c completed a command
+         */
+        bool push(char c, serial_command *out);
+
+        /** Malformed or unknown commands so far */
+        uint32_t getErrors() const { return errors; }
+};
+
+#endif
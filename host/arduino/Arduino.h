@@ -0,0 +1,64 @@
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the Arduino core API
+ *
+ * Host only: put host/arduino on the include path to build the Arduino
+ * drivers (abi_encoder_arduino, LS7366R_Single, as5047p_arduino) against
+ * host_sim. Only the calls the drivers use are provided. See
+ * host_arduino.h for the interrupt model.
+ */
+
+#ifndef _HOST_ARDUINO_CORE_H
+#define _HOST_ARDUINO_CORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define HIGH            1
+#define LOW             0
+
+#define INPUT           0x00
+#define OUTPUT          0x01
+#define INPUT_PULLUP    0x02
+#define INPUT_PULLDOWN  0x03
+
+#define RISING          0x01
+#define FALLING         0x02
+#define CHANGE          0x03
+
+#define MSBFIRST        1
+#define LSBFIRST        0
+
+#define IRAM_ATTR
+
+// binary.h constants used by the drivers (LS7366R)
+#define B00000000       0x00
+#define B00000011       0x03
+#define B00001000       0x08
+#define B00010000       0x10
+#define B00011000       0x18
+#define B00100000       0x20
+#define B00101000       0x28
+#define B00110000       0x30
+#define B01000000       0x40
+#define B10000000       0x80
+#define B11000000       0xC0
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void noInterrupts();
+void interrupts();
+
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(int irq, void (*fn)(), int mode);
+void attachInterruptArg(int irq, void (*fn)(void *), void *arg, int mode);
+void detachInterrupt(int irq);
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file SPI.h
+ * @brief Host stand-in for the Arduino SPI library
+ *
+ * Host only. transfer() advances virtual time by 8 clocks at the speed
+ * of the current SPISettings and exchanges the byte with every simulated
+ * device attached with host_spi_attach() whose CS pin is low.
+ */
+
+#ifndef _HOST_ARDUINO_SPI_H
+#define _HOST_ARDUINO_SPI_H
+
+#include "Arduino.h"
+
+#define SPI_MODE0       0x00
+#define SPI_MODE1       0x01
+#define SPI_MODE2       0x02
+#define SPI_MODE3       0x03
+
+/** Simulated SPI devices */
+#define HOST_SPI_DEVICES    8
+
+/** Byte exchange with a simulated device: gets MOSI, returns MISO */
+typedef uint8_t (*host_spi_transfer)(void *ctx, uint8_t mosi);
+
+class SPISettings{
+    public:
+        uint32_t clock;
+        uint8_t bit_order;
+        uint8_t mode;
+
+        SPISettings() : clock(1000000), bit_order(MSBFIRST), mode(SPI_MODE0) {}
+        SPISettings(uint32_t clock, uint8_t bit_order, uint8_t mode)
+            : clock(clock ? clock : 1), bit_order(bit_order), mode(mode) {}
+};
+
+class SPIClass{
+    private:
+        SPISettings settings;
+
+    public:
+        void begin() {}
+        void end() {}
+        void beginTransaction(SPISettings s) { settings = s; }
+        void endTransaction() {}
+        uint8_t transfer(uint8_t data);
+        uint16_t transfer16(uint16_t data);
+};
+
+extern SPIClass SPI;
+
+/** Attach a simulated device selected by cs_pin (active low)
+ *
+ *  @return     false if all HOST_SPI_DEVICES slots are in use
+ */
+bool host_spi_attach(int cs_pin, host_spi_transfer fn, void *ctx);
+
+/** Remove a device added with host_spi_attach() */
+void host_spi_detach(int cs_pin, host_spi_transfer fn, void *ctx);
+
+#endif
@@ -0,0 +1,273 @@
+/**
+ * @file host_arduino.cpp
+ * @brief Host implementation of the Arduino core and SPI stand-ins
+ */
+
+#include "Arduino.h"
+#include "SPI.h"
+#include "host_arduino.h"
+#include "host_sim.h"
+
+struct host_irq{
+    void (*fn)(void *);
+    void (*fn_plain)();
+    void *arg;
+    int mode;
+    bool pending;
+};
+
+struct host_spi_device{
+    int cs_pin;
+    host_spi_transfer fn;
+    void *ctx;
+};
+
+static host_irq irqs[HOST_SIM_PINS];
+static bool masked = false;
+static bool in_isr = false;
+static bool dispatch_scheduled = false;
+static uint32_t irq_latency_ns = 0;
+static uint32_t irq_isr_ns = 0;
+static uint32_t lost = 0;
+static uint32_t serviced = 0;
+
+static host_spi_device spi_devices[HOST_SPI_DEVICES];
+
+SPIClass SPI;
+
+// ----------------------------------------------------------------------------
+// Interrupts
+// ----------------------------------------------------------------------------
+
+static void dispatch(void *ctx);
+
+static bool anyPending(){
+    for (int i = 0; i < HOST_SIM_PINS; i++) {
+        if (irqs[i].pending) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Start the next handler once the CPU is free
+static void kick(){
+    if (in_isr || masked || dispatch_scheduled || !anyPending()) {
+        return;
+    }
+    if (irq_latency_ns == 0) {
+        dispatch(0);
+        return;
+    }
+    dispatch_scheduled = true;
+    host_sim::schedule(host_sim::nanos() + irq_latency_ns, dispatch, 0);
+}
+
+static void isrEnd(void *){
+    in_isr = false;
+    kick();
+}
+
+static void dispatch(void *){
+    dispatch_scheduled = false;
+    if (masked || in_isr) {
+        return;
+    }
+
+    // Lowest pin first, like a fixed-priority GPIO status scan
+    for (int i = 0; i < HOST_SIM_PINS; i++) {
+        host_irq &irq = irqs[i];
+        if (!irq.pending) {
+            continue;
+        }
+        irq.pending = false;
+        in_isr = true;
+        serviced++;
+        if (irq.fn) {
+            irq.fn(irq.arg);
+        } else if (irq.fn_plain) {
+            irq.fn_plain();
+        }
+        if (irq_isr_ns) {
+            host_sim::schedule(host_sim::nanos() + irq_isr_ns, isrEnd, 0);
+        } else {
+            isrEnd(0);
+        }
+        return;
+    }
+}
+
+static void onPinChange(void *, int pin, int level){
+    host_irq &irq = irqs[pin];
+    if (!irq.fn && !irq.fn_plain) {
+        return;
+    }
+    if ((irq.mode == RISING && !level) || (irq.mode == FALLING && level)) {
+        return;
+    }
+    if (irq.pending) {
+        lost++;
+        return;
+    }
+    irq.pending = true;
+    kick();
+}
+
+void host_arduino::reset(){
+    for (int i = 0; i < HOST_SIM_PINS; i++) {
+        if (irqs[i].fn || irqs[i].fn_plain) {
+            host_sim::unlisten(i, onPinChange, 0);
+        }
+        irqs[i].fn = 0;
+        irqs[i].fn_plain = 0;
+        irqs[i].pending = false;
+    }
+    for (int i = 0; i < HOST_SPI_DEVICES; i++) {
+        spi_devices[i].fn = 0;
+    }
+    host_sim::cancel(dispatch, 0);
+    host_sim::cancel(isrEnd, 0);
+    masked = false;
+    in_isr = false;
+    dispatch_scheduled = false;
+    lost = 0;
+    serviced = 0;
+}
+
+void host_arduino::setInterruptTiming(uint32_t latency_ns, uint32_t isr_ns){
+    irq_latency_ns = latency_ns;
+    irq_isr_ns = isr_ns;
+}
+
+uint32_t host_arduino::getLostInterrupts(){
+    return lost;
+}
+
+uint32_t host_arduino::getServicedInterrupts(){
+    return serviced;
+}
+
+static void attach(int irq, void (*fn)(void *), void (*fn_plain)(), void *arg, int mode){
+    if (irq < 0 || irq >= HOST_SIM_PINS) {
+        return;
+    }
+    if (!irqs[irq].fn && !irqs[irq].fn_plain) {
+        host_sim::listen(irq, onPinChange, 0);
+    }
+    irqs[irq].fn = fn;
+    irqs[irq].fn_plain = fn_plain;
+    irqs[irq].arg = arg;
+    irqs[irq].mode = mode;
+    irqs[irq].pending = false;
+}
+
+int digitalPinToInterrupt(uint8_t pin){
+    return pin;
+}
+
+void attachInterrupt(int irq, void (*fn)(), int mode){
+    attach(irq, 0, fn, 0, mode);
+}
+
+void attachInterruptArg(int irq, void (*fn)(void *), void *arg, int mode){
+    attach(irq, fn, 0, arg, mode);
+}
+
+void detachInterrupt(int irq){
+    if (irq < 0 || irq >= HOST_SIM_PINS || (!irqs[irq].fn && !irqs[irq].fn_plain)) {
+        return;
+    }
+    host_sim::unlisten(irq, onPinChange, 0);
+    irqs[irq].fn = 0;
+    irqs[irq].fn_plain = 0;
+    irqs[irq].pending = false;
+}
+
+void noInterrupts(){
+    masked = true;
+}
+
+void interrupts(){
+    masked = false;
+    kick();
+}
+
+// ----------------------------------------------------------------------------
+// Pins and time
+// ----------------------------------------------------------------------------
+
+void pinMode(uint8_t pin, uint8_t mode){
+    if (mode == INPUT_PULLUP) {
+        host_sim::pull(pin, 1);
+    } else if (mode == INPUT_PULLDOWN) {
+        host_sim::pull(pin, 0);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t level){
+    host_sim::write(pin, level);
+}
+
+int digitalRead(uint8_t pin){
+    return host_sim::read(pin);
+}
+
+unsigned long micros(){
+    return host_sim::micros();
+}
+
+unsigned long millis(){
+    return (unsigned long)(host_sim::nanos() / 1000000);
+}
+
+void delay(unsigned long ms){
+    host_sim::advance((uint64_t)ms * 1000000);
+}
+
+void delayMicroseconds(unsigned int us){
+    host_sim::advance((uint64_t)us * 1000);
+}
+
+// ----------------------------------------------------------------------------
+// SPI
+// ----------------------------------------------------------------------------
+
+uint8_t SPIClass::transfer(uint8_t data){
+    // The byte is exchanged at the end of its 8 clocks
+    host_sim::advance((uint64_t)8 * 1000000000 / settings.clock);
+
+    uint8_t miso = 0xFF;
+    for (int i = 0; i < HOST_SPI_DEVICES; i++) {
+        host_spi_device &d = spi_devices[i];
+        if (d.fn && host_sim::read(d.cs_pin) == 0) {
+            miso &= d.fn(d.ctx, data);
+        }
+    }
+    return miso;
+}
+
+uint16_t SPIClass::transfer16(uint16_t data){
+    uint16_t hi = transfer((uint8_t)(data >> 8));
+    return (uint16_t)((hi << 8) | transfer((uint8_t)data));
+}
+
+bool host_spi_attach(int cs_pin, host_spi_transfer fn, void *ctx){
+    for (int i = 0; i < HOST_SPI_DEVICES; i++) {
+        if (!spi_devices[i].fn) {
+            spi_devices[i].cs_pin = cs_pin;
+            spi_devices[i].fn = fn;
+            spi_devices[i].ctx = ctx;
+            return true;
+        }
+    }
+    return false;
+}
+
+void host_spi_detach(int cs_pin, host_spi_transfer fn, void *ctx){
+    for (int i = 0; i < HOST_SPI_DEVICES; i++) {
+        host_spi_device &d = spi_devices[i];
+        if (d.fn == fn && d.ctx == ctx && d.cs_pin == cs_pin) {
+            d.fn = 0;
+        }
+    }
+}
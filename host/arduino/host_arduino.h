@@ -0,0 +1,43 @@
+/**
+ * @file host_arduino.h
+ * @brief Interrupt model behind the host Arduino stand-in
+ *
+ * Host only. attachInterruptArg() handlers are run on virtual time like
+ * a single-core MCU would run them:
+ *
+ * - a matching pin edge sets the pin's pending flag; a second edge while
+ *   the flag is still set is lost (counted by getLostInterrupts())
+ * - a pending handler starts latency_ns after it can run (CPU not in
+ *   another handler, interrupts not masked) and reads the pins then
+ * - each handler keeps the CPU for isr_ns after it starts
+ *
+ * With the defaults left at zero every edge is handled at once, which
+ * is the ideal decoder. Realistic values expose the edge rate at which
+ * a software decoder falls behind.
+ */
+
+#ifndef _HOST_ARDUINO_H
+#define _HOST_ARDUINO_H
+
+#include <stdint.h>
+
+class host_arduino{
+    public:
+        /** Drop all handlers and counters (call after host_sim::reset()) */
+        static void reset();
+
+        /** Set the interrupt timing
+         *
+         *  @param latency_ns   Edge (or end of the previous handler) to handler start
+         *  @param isr_ns       CPU time per handler
+         */
+        static void setInterruptTiming(uint32_t latency_ns, uint32_t isr_ns);
+
+        /** Edges lost because their pin was already pending */
+        static uint32_t getLostInterrupts();
+
+        /** Handlers run */
+        static uint32_t getServicedInterrupts();
+};
+
+#endif
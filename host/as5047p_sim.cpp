@@ -0,0 +1,121 @@
+/**
+ * @file as5047p_sim.cpp
+ * @brief Implementation of simulated AS5047P
+ */
+
+#include "as5047p_sim.h"
+#include "host_sim.h"
+
+#define AS5047P_SIM_ERRFL       0x0001
+#define AS5047P_SIM_DIAAGC      0x3FFC
+#define AS5047P_SIM_MAG         0x3FFD
+#define AS5047P_SIM_ANGLEUNC    0x3FFE
+#define AS5047P_SIM_ANGLECOM    0x3FFF
+
+#define AS5047P_SIM_PARERR      0x0004
+#define AS5047P_SIM_EF          0x4000
+
+as5047p_sim::as5047p_sim(int cs_pin, int miso_pin, int clk_pin, int mosi_pin)
+    : cs_pin(cs_pin), miso_pin(miso_pin), clk_pin(clk_pin), mosi_pin(mosi_pin),
+      angle(0), angle_unc(0), mag(0x1000), diag(0x0180), errfl(0), corrupt(0), corrupt_skip(0), response(0), shift_out(0), shift_in(0), bits(0),
+      write_pending(false), write_address(0), frames(0) {
+    for (int i = 0; i < 0x40; i++) {
+        regs[i] = 0;
+    }
+    host_sim::listen(cs_pin, onPin, this);
+    host_sim::listen(clk_pin, onPin, this);
+}
+
+as5047p_sim::~as5047p_sim(){
+    host_sim::unlisten(cs_pin, onPin, this);
+    host_sim::unlisten(clk_pin, onPin, this);
+}
+
+uint16_t as5047p_sim::withParity(uint16_t word){
+    word &= 0x7FFF;
+    uint16_t p = word;
+    p ^= p >> 8;
+    p ^= p >> 4;
+    p ^= p >> 2;
+    p ^= p >> 1;
+    return word | ((p & 1) << 15);
+}
+
+uint16_t as5047p_sim::getRegister(uint16_t address) const{
+    return address < 0x40 ? regs[address] : 0;
+}
+
+uint16_t as5047p_sim::readAddress(uint16_t address){
+    switch (address) {
+        case AS5047P_SIM_ANGLECOM:  return angle;
+        case AS5047P_SIM_ANGLEUNC:  return angle_unc;
+        case AS5047P_SIM_MAG:       return mag;
+        case AS5047P_SIM_DIAAGC:    return diag;
+        case AS5047P_SIM_ERRFL: {
+            uint16_t flags = errfl;
+            errfl = 0;
+            return flags;
+        }
+    }
+    return getRegister(address);
+}
+
+void as5047p_sim::onPin(void *ctx, int pin, int level){
+    as5047p_sim *sim = (as5047p_sim*)ctx;
+
+    if (pin == sim->cs_pin) {
+        if (level == 0) {
+            // Frame start: present the pending response
+            sim->shift_out = sim->response;
+            if (sim->corrupt && sim->corrupt_skip-- == 0) {
+                sim->shift_out ^= sim->corrupt;
+                sim->corrupt = 0;
+            }
+            sim->shift_in = 0;
+            sim->bits = 0;
+        } else if (sim->bits >= 16) {
+            sim->frameEnd();
+        }
+        return;
+    }
+
+    // Rising clock while selected: output the next bit, latch MOSI
+    if (pin == sim->clk_pin && level == 1 && host_sim::read(sim->cs_pin) == 0 && sim->bits < 16) {
+        host_sim::write(sim->miso_pin, (sim->shift_out >> (15 - sim->bits)) & 1);
+        int mosi = sim->mosi_pin < 0 ? 1 : host_sim::read(sim->mosi_pin);
+        sim->shift_in = (uint16_t)((sim->shift_in << 1) | mosi);
+        sim->bits++;
+    }
+}
+
+void as5047p_sim::frameEnd(){
+    frames++;
+
+    if (withParity(shift_in) != shift_in) {
+        // Bad parity: ignore the command (and a pending write's data)
+        write_pending = false;
+        errfl |= AS5047P_SIM_PARERR;
+        response = withParity(AS5047P_SIM_EF);
+        return;
+    }
+
+    if (write_pending) {
+        // Data frame of a write: store, answer with the new content
+        write_pending = false;
+        if (write_address < 0x40) {
+            regs[write_address] = shift_in & 0x3FFF;
+        }
+        response = withParity(readAddress(write_address));
+        return;
+    }
+
+    uint16_t address = shift_in & 0x3FFF;
+    if (shift_in & 0x4000) {
+        response = withParity(readAddress(address));
+    } else {
+        // Write command: the data frame returns the old content
+        write_pending = true;
+        write_address = address;
+        response = withParity(readAddress(address));
+    }
+}
@@ -0,0 +1,88 @@
+/**
+ * @file as5047p_sim.h
+ * @brief Simulated AS5047P SPI slave on host_sim pins
+ *
+ * Host only. Follows the sensor's frame protocol: the command is shifted
+ * in on the rising clock edges while CS is low and executed when CS goes
+ * high; the response to a command is returned in the next frame. Each
+ * frame needs its own CS low period (clocks past 16 are ignored). Every
+ * response carries the even-parity bit (bit 15). A command with bad
+ * parity is ignored, sets ERRFL.PARERR and is answered with the error
+ * flag (bit 14); reading ERRFL clears it. Registers hold the last value
+ * written; ANGLECOM, ANGLEUNC, MAG and DIAAGC return what the test set.
+ */
+
+#ifndef _AS5047P_SIM_H
+#define _AS5047P_SIM_H
+
+#include <stdint.h>
+
+class as5047p_sim{
+    private:
+        int cs_pin;
+        int miso_pin;
+        int clk_pin;
+        int mosi_pin;
+
+        uint16_t regs[0x40];        // Writable registers, low address space
+        uint16_t angle;             // 14-bit angle (ANGLECOM)
+        uint16_t angle_unc;         // ANGLEUNC
+        uint16_t mag;               // MAG
+        uint16_t diag;              // DIAAGC
+        uint16_t errfl;             // ERRFL
+        uint16_t corrupt;           // XORed into a later response
+        uint32_t corrupt_skip;      // Frames to go before it
+        uint16_t response;          // Word returned in the next frame
+        uint16_t shift_out;
+        uint16_t shift_in;
+        int bits;
+        bool write_pending;         // Next frame is the data of a write
+        uint16_t write_address;
+        uint32_t frames;
+
+        static void onPin(void *ctx, int pin, int level);
+        void frameEnd();
+        uint16_t readAddress(uint16_t address);
+
+    public:
+        /** Creates as5047p_sim object attached to the given pins
+         *
+         *  @param cs_pin       CS Pin
+         *  @param miso_pin     MISO Pin (driven by the simulated sensor)
+         *  @param clk_pin      CLK Pin
+         *  @param mosi_pin     MOSI Pin (-1 = not connected, reads as 1)
+         */
+        as5047p_sim(int cs_pin, int miso_pin, int clk_pin, int mosi_pin);
+        ~as5047p_sim();
+
+        /** Set the magnet angle
+         *
+         *  @param raw  14-bit angle (0..16383)
+         */
+        void setAngle(uint16_t raw) { angle = angle_unc = raw & 0x3FFF; }
+
+        /** Set the uncompensated angle (after setAngle) */
+        void setAngleUncompensated(uint16_t raw) { angle_unc = raw & 0x3FFF; }
+
+        /** Set the magnitude and diagnostics registers */
+        void setMagnitude(uint16_t mag) { this->mag = mag & 0x3FFF; }
+        void setDiagnostics(uint16_t diag) { this->diag = diag & 0x3FFF; }
+
+        /** Flip bits of a later response (line noise)
+         *
+         *  @param mask     Bits to flip
+         *  @param skip     Frames to pass untouched first (0 = next frame)
+         */
+        void corruptResponse(uint16_t mask, uint32_t skip = 0) { corrupt = mask; corrupt_skip = skip; }
+
+        /** Get a register value as stored by the simulated sensor */
+        uint16_t getRegister(uint16_t address) const;
+
+        /** Number of complete 16-bit frames seen */
+        uint32_t getFrames() const { return frames; }
+
+        /** Add even parity (bit 15) to a 15-bit word */
+        static uint16_t withParity(uint16_t word);
+};
+
+#endif
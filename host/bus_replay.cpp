@@ -0,0 +1,112 @@
+/**
+ * @file bus_replay.cpp
+ * @brief Implementation of trace replay device
+ */
+
+#include "bus_replay.h"
+#include "host_sim.h"
+#include "SPI.h"
+
+bus_replay::bus_replay(const bus_trace_record *records, uint32_t count, int cs_pin)
+    : records(records), count(count), cursor(0), cs_pin(cs_pin), miso_pin(-1), clk_pin(-1), mosi_pin(-1),
+      current(0), position(0), shift_in(0), frames(0), mismatches(0), missing(0) {
+    host_sim::listen(cs_pin, onPin, this);
+    host_spi_attach(cs_pin, onTransfer, this);
+}
+
+bus_replay::bus_replay(const bus_trace_record *records, uint32_t count,
+                       int cs_pin, int miso_pin, int clk_pin, int mosi_pin)
+    : records(records), count(count), cursor(0), cs_pin(cs_pin), miso_pin(miso_pin), clk_pin(clk_pin),
+      mosi_pin(mosi_pin), current(0), position(0), shift_in(0), frames(0), mismatches(0), missing(0) {
+    host_sim::listen(cs_pin, onPin, this);
+    host_sim::listen(clk_pin, onPin, this);
+}
+
+bus_replay::~bus_replay(){
+    host_sim::unlisten(cs_pin, onPin, this);
+    if (clk_pin < 0) {
+        host_spi_detach(cs_pin, onTransfer, this);
+    } else {
+        host_sim::unlisten(clk_pin, onPin, this);
+    }
+}
+
+const bus_trace_record *bus_replay::peek(uint32_t ahead) const{
+    for (uint32_t i = cursor; i < count; i++) {
+        if (records[i].device == cs_pin && ahead-- == 0) {
+            return &records[i];
+        }
+    }
+    return 0;
+}
+
+const bus_trace_record *bus_replay::take(){
+    while (cursor < count && records[cursor].device != cs_pin) {
+        cursor++;
+    }
+    if (cursor == count) {
+        return 0;
+    }
+    return &records[cursor++];
+}
+
+void bus_replay::skip(){
+    take();
+}
+
+void bus_replay::compare(uint16_t index, uint8_t mosi){
+    if (current && index < BUS_TRACE_BYTES && index < current->length &&
+        !(current->kind & BUS_TRACE_NO_MOSI) && mosi != current->out[index]) {
+        mismatches++;
+    }
+}
+
+void bus_replay::onPin(void *ctx, int pin, int level){
+    bus_replay *r = (bus_replay*)ctx;
+
+    if (pin == r->cs_pin) {
+        if (level == 0) {
+            r->current = r->take();
+            if (!r->current) {
+                r->missing++;
+            }
+            r->position = 0;
+            r->shift_in = 0;
+        } else {
+            uint16_t length = r->clk_pin < 0 ? r->position : r->position / 8;
+            if (r->current && length != r->current->length) {
+                r->mismatches++;
+            }
+            r->frames++;
+            r->current = 0;
+        }
+        return;
+    }
+
+    // AS5047P: rising clock while selected, output the next bit, latch MOSI
+    if (level == 1 && host_sim::read(r->cs_pin) == 0) {
+        uint16_t index = r->position / 8;
+        uint8_t bit = 7 - r->position % 8;
+        int miso = 1;
+        if (r->current && index < BUS_TRACE_BYTES && index < r->current->length) {
+            miso = (r->current->in[index] >> bit) & 1;
+        }
+        host_sim::write(r->miso_pin, miso);
+        int mosi = r->mosi_pin < 0 ? 1 : host_sim::read(r->mosi_pin);
+        r->shift_in = (uint8_t)((r->shift_in << 1) | mosi);
+        if (bit == 0) {
+            r->compare(index, r->shift_in);
+        }
+        r->position++;
+    }
+}
+
+uint8_t bus_replay::onTransfer(void *ctx, uint8_t mosi){
+    bus_replay *r = (bus_replay*)ctx;
+    uint16_t index = r->position++;
+    r->compare(index, mosi);
+    if (r->current && index < BUS_TRACE_BYTES && index < r->current->length) {
+        return r->current->in[index];
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file bus_replay.h
+ * @brief Simulated device that answers from a recorded bus trace
+ *
+ * Host only. Stands in for one traced device (bus_trace.h): every CS
+ * frame the driver runs takes the next recorded frame of that device and
+ * returns its MISO bytes, while the MOSI bytes the driver sends are
+ * compared with the recorded ones. A driver replayed against a field
+ * trace therefore sees exactly the responses it saw in the field, and
+ * any change in what it sends shows up as a mismatch.
+ *
+ * - BUS_TRACE_LS7366R: attached to the host SPI stand-in (host_spi_attach)
+ * - BUS_TRACE_AS5047P: bit level on host_sim pins, like as5047p_sim
+ *
+ * The caller decides which driver call replays which frames; skip()
+ * passes over frames it does not replay.
+ */
+
+#ifndef _BUS_REPLAY_H
+#define _BUS_REPLAY_H
+
+#include <stdint.h>
+#include "bus_trace.h"
+
+class bus_replay{
+    private:
+        const bus_trace_record *records;
+        uint32_t count;
+        uint32_t cursor;                    // First record not yet replayed
+        int cs_pin;
+        int miso_pin;
+        int clk_pin;
+        int mosi_pin;
+
+        const bus_trace_record *current;    // Frame in progress (0: none recorded)
+        uint16_t position;                  // Bytes (LS7366R) or bits (AS5047P) so far
+        uint8_t shift_in;
+
+        uint32_t frames;
+        uint32_t mismatches;
+        uint32_t missing;
+
+        static void onPin(void *ctx, int pin, int level);
+        static uint8_t onTransfer(void *ctx, uint8_t mosi);
+        const bus_trace_record *take();
+        void compare(uint16_t index, uint8_t mosi);
+
+    public:
+        /** LS7366R (SPI) device
+         *
+         *  @param records  Trace (kept by reference)
+         *  @param count    Records in the trace
+         *  @param cs_pin   Device (CS pin) to answer for
+         */
+        bus_replay(const bus_trace_record *records, uint32_t count, int cs_pin);
+
+        /** AS5047P (bit-banged) device
+         *
+         *  @param mosi_pin     -1 for listen-only wiring
+         */
+        bus_replay(const bus_trace_record *records, uint32_t count,
+                   int cs_pin, int miso_pin, int clk_pin, int mosi_pin);
+        ~bus_replay();
+
+        /** Next recorded frame of this device, 0 at the end */
+        const bus_trace_record *peek(uint32_t ahead = 0) const;
+
+        /** Pass over the next recorded frame without replaying it */
+        void skip();
+
+        /** Frames replayed */
+        uint32_t getFrames() const { return frames; }
+
+        /** MOSI bytes (or frame lengths) that differ from the trace */
+        uint32_t getMismatches() const { return mismatches; }
+
+        /** Frames run after the trace of this device ended */
+        uint32_t getMissing() const { return missing; }
+};
+
+#endif
@@ -0,0 +1,160 @@
+/**
+ * @file host_sim.cpp
+ * @brief Implementation of host pin and time simulation
+ */
+
+#include "host_sim.h"
+
+struct host_sim_pin{
+    int level;
+    bool driven;
+    host_sim_listener fn[HOST_SIM_LISTENERS];
+    void *ctx[HOST_SIM_LISTENERS];
+};
+
+struct host_sim_timer{
+    uint64_t at_ns;
+    uint64_t seq;           // Scheduling order, for ties
+    host_sim_event fn;
+    void *ctx;
+};
+
+static host_sim_pin pins[HOST_SIM_PINS];
+static uint64_t now_ns = 0;
+
+static host_sim_timer timers[HOST_SIM_EVENTS];
+static uint64_t timer_seq = 0;
+
+static bool valid(int pin){
+    return pin >= 0 && pin < HOST_SIM_PINS;
+}
+
+void host_sim::reset(){
+    for (int i = 0; i < HOST_SIM_PINS; i++) {
+        pins[i].level = 0;
+        pins[i].driven = false;
+        for (int j = 0; j < HOST_SIM_LISTENERS; j++) {
+            pins[i].fn[j] = 0;
+            pins[i].ctx[j] = 0;
+        }
+    }
+    for (int i = 0; i < HOST_SIM_EVENTS; i++) {
+        timers[i].fn = 0;
+    }
+    now_ns = 0;
+    timer_seq = 0;
+}
+
+uint64_t host_sim::nanos(){
+    return now_ns;
+}
+
+uint32_t host_sim::micros(){
+    return (uint32_t)(now_ns / 1000);
+}
+
+void host_sim::advance(uint64_t ns){
+    uint64_t target = now_ns + ns;
+
+    for (;;) {
+        int next = -1;
+        for (int i = 0; i < HOST_SIM_EVENTS; i++) {
+            if (!timers[i].fn || timers[i].at_ns > target) {
+                continue;
+            }
+            if (next < 0 || timers[i].at_ns < timers[next].at_ns ||
+                (timers[i].at_ns == timers[next].at_ns && timers[i].seq < timers[next].seq)) {
+                next = i;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+
+        host_sim_timer t = timers[next];
+        timers[next].fn = 0;
+        if (t.at_ns > now_ns) {
+            now_ns = t.at_ns;
+        }
+        t.fn(t.ctx);
+    }
+
+    if (target > now_ns) {
+        now_ns = target;
+    }
+}
+
+bool host_sim::schedule(uint64_t at_ns, host_sim_event fn, void *ctx){
+    for (int i = 0; i < HOST_SIM_EVENTS; i++) {
+        if (!timers[i].fn) {
+            timers[i].at_ns = at_ns;
+            timers[i].seq = timer_seq++;
+            timers[i].fn = fn;
+            timers[i].ctx = ctx;
+            return true;
+        }
+    }
+    return false;
+}
+
+void host_sim::cancel(host_sim_event fn, void *ctx){
+    for (int i = 0; i < HOST_SIM_EVENTS; i++) {
+        if (timers[i].fn == fn && timers[i].ctx == ctx) {
+            timers[i].fn = 0;
+        }
+    }
+}
+
+void host_sim::write(int pin, int level){
+    if (!valid(pin)) {
+        return;
+    }
+    host_sim_pin &p = pins[pin];
+    level = level ? 1 : 0;
+    p.driven = true;
+    if (p.level == level) {
+        return;
+    }
+    p.level = level;
+    for (int j = 0; j < HOST_SIM_LISTENERS; j++) {
+        if (p.fn[j]) {
+            p.fn[j](p.ctx[j], pin, level);
+        }
+    }
+}
+
+int host_sim::read(int pin){
+    return valid(pin) ? pins[pin].level : 0;
+}
+
+void host_sim::pull(int pin, int level){
+    if (valid(pin) && !pins[pin].driven) {
+        pins[pin].level = level ? 1 : 0;
+    }
+}
+
+bool host_sim::listen(int pin, host_sim_listener fn, void *ctx){
+    if (!valid(pin)) {
+        return false;
+    }
+    for (int j = 0; j < HOST_SIM_LISTENERS; j++) {
+        if (!pins[pin].fn[j]) {
+            pins[pin].fn[j] = fn;
+            pins[pin].ctx[j] = ctx;
+            return true;
+        }
+    }
+    return false;
+}
+
+void host_sim::unlisten(int pin, host_sim_listener fn, void *ctx){
+    if (!valid(pin)) {
+        return;
+    }
+    for (int j = 0; j < HOST_SIM_LISTENERS; j++) {
+        if (pins[pin].fn[j] == fn && pins[pin].ctx[j] == ctx) {
+            pins[pin].fn[j] = 0;
+            pins[pin].ctx[j] = 0;
+        }
+    }
+}
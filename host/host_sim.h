@@ -0,0 +1,95 @@
+/**
+ * @file host_sim.h
+ * @brief Host-side pin and time simulation
+ *
+ * Host only. Models the MCU pins as a table of levels with change
+ * listeners, and time as a virtual nanosecond clock. Simulated devices
+ * (as5047p_sim) listen on their input pins and drive their outputs;
+ * platform_host.h maps the driver cores onto it.
+ *
+ * Virtual time only moves when something advances it (driver delays,
+ * signal generators, test code), so runs are deterministic and as fast
+ * as the host allows. Timed events (signal edges, interrupt dispatch)
+ * are scheduled on the same clock and run in order from inside advance(),
+ * so they interleave with a driver's delays as they would on hardware.
+ */
+
+#ifndef _HOST_SIM_H
+#define _HOST_SIM_H
+
+#include <stdint.h>
+
+/** Number of simulated pins */
+#define HOST_SIM_PINS       64
+
+/** Listeners per pin */
+#define HOST_SIM_LISTENERS  4
+
+/** Pending timed events */
+#define HOST_SIM_EVENTS     16
+
+/** Called after a pin changes level */
+typedef void (*host_sim_listener)(void *ctx, int pin, int level);
+
+/** Called when a scheduled time is reached */
+typedef void (*host_sim_event)(void *ctx);
+
+class host_sim{
+    public:
+        /** Clear pins, listeners and time */
+        static void reset();
+
+        /** Get virtual time (ns) */
+        static uint64_t nanos();
+
+        /** Get virtual time (us), wrapping like micros() */
+        static uint32_t micros();
+
+        /** Advance virtual time, running the events that fall due
+         *
+         *  @param ns   Nanoseconds
+         */
+        static void advance(uint64_t ns);
+
+        /** Run fn when virtual time reaches at_ns
+         *
+         *  Events at the same time run in the order they were scheduled.
+         *  An event in the past runs at the next advance().
+         *
+         *  @param at_ns    Virtual time (ns)
+         *  @param fn       Event
+         *  @param ctx      Passed back to fn
+         *  @return         false if all HOST_SIM_EVENTS slots are in use
+         */
+        static bool schedule(uint64_t at_ns, host_sim_event fn, void *ctx);
+
+        /** Remove pending events added with schedule() */
+        static void cancel(host_sim_event fn, void *ctx);
+
+        /** Set a pin level; listeners are called when it changes
+         *
+         *  @param pin      Pin number
+         *  @param level    0 or 1
+         */
+        static void write(int pin, int level);
+
+        /** Read a pin level */
+        static int read(int pin);
+
+        /** Set the level of an undriven pin (pull-up / pull-down) */
+        static void pull(int pin, int level);
+
+        /** Call fn whenever pin changes level
+         *
+         *  @param pin  Pin number
+         *  @param fn   Listener
+         *  @param ctx  Passed back to fn
+         *  @return     false if the pin has no free listener slot
+         */
+        static bool listen(int pin, host_sim_listener fn, void *ctx);
+
+        /** Remove a listener added with listen() */
+        static void unlisten(int pin, host_sim_listener fn, void *ctx);
+};
+
+#endif
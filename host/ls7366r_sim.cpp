@@ -0,0 +1,172 @@
+/**
+ * @file ls7366r_sim.cpp
+ * @brief Implementation of simulated LS7366R
+ */
+
+#include "ls7366r_sim.h"
+#include "host_sim.h"
+#include "SPI.h"
+
+// Instruction register: op (bits 7-6), register (bits 5-3)
+#define LS7366R_SIM_OP_MASK     0xC0
+#define LS7366R_SIM_OP_CLR      0x00
+#define LS7366R_SIM_OP_RD       0x40
+#define LS7366R_SIM_OP_WR       0x80
+#define LS7366R_SIM_OP_LOAD     0xC0
+
+#define LS7366R_SIM_REG_MASK    0x38
+#define LS7366R_SIM_MDR0        0x08
+#define LS7366R_SIM_MDR1        0x10
+#define LS7366R_SIM_DTR         0x18
+#define LS7366R_SIM_CNTR        0x20
+#define LS7366R_SIM_OTR         0x28
+#define LS7366R_SIM_STR         0x30
+
+#define LS7366R_SIM_MDR1_DISABLE    0x04
+#define LS7366R_SIM_STR_CEN         0x08
+#define LS7366R_SIM_STR_UD          0x02
+#define LS7366R_SIM_STR_S           0x01
+
+ls7366r_sim::ls7366r_sim(int cs_pin, int a_pin, int b_pin)
+    : cs_pin(cs_pin), a_pin(a_pin), b_pin(b_pin),
+      mdr0(0), mdr1(0), dtr(0), cntr(0), otr(0), str(0), ab(0),
+      ir(0), byte_index(0), shift(0) {
+    ab = (uint8_t)((host_sim::read(a_pin) << 1) | host_sim::read(b_pin));
+    host_sim::listen(cs_pin, onPin, this);
+    host_sim::listen(a_pin, onPin, this);
+    host_sim::listen(b_pin, onPin, this);
+    host_spi_attach(cs_pin, onTransfer, this);
+}
+
+ls7366r_sim::~ls7366r_sim(){
+    host_sim::unlisten(cs_pin, onPin, this);
+    host_sim::unlisten(a_pin, onPin, this);
+    host_sim::unlisten(b_pin, onPin, this);
+    host_spi_detach(cs_pin, onTransfer, this);
+}
+
+int ls7366r_sim::width() const{
+    return 4 - (mdr1 & 0x03);
+}
+
+uint32_t ls7366r_sim::mask() const{
+    return width() == 4 ? 0xFFFFFFFF : (((uint32_t)1 << (8 * width())) - 1);
+}
+
+int32_t ls7366r_sim::getCounter() const{
+    int bits = 8 * width();
+    if (bits == 32) {
+        return (int32_t)cntr;
+    }
+    // Sign extend
+    uint32_t sign = (uint32_t)1 << (bits - 1);
+    return (int32_t)((cntr ^ sign) - sign);
+}
+
+void ls7366r_sim::onPin(void *ctx, int pin, int level){
+    ls7366r_sim *sim = (ls7366r_sim*)ctx;
+
+    if (pin == sim->cs_pin) {
+        // New frame on the falling edge
+        if (level == 0) {
+            sim->byte_index = 0;
+        }
+        return;
+    }
+
+    uint8_t next = (uint8_t)((host_sim::read(sim->a_pin) << 1) | host_sim::read(sim->b_pin));
+    static const int8_t table[16] = {
+         0, -1,  1,  0,
+         1,  0,  0, -1,
+        -1,  0,  0,  1,
+         0,  1, -1,  0
+    };
+    int8_t dir = table[(sim->ab << 2) | next];
+    sim->ab = next;
+
+    if (dir == 0 || (sim->mdr1 & LS7366R_SIM_MDR1_DISABLE)) {
+        return;
+    }
+    sim->cntr = (sim->cntr + (uint32_t)(int32_t)dir) & sim->mask();
+    sim->str = (uint8_t)((sim->str & ~LS7366R_SIM_STR_UD) | (dir > 0 ? LS7366R_SIM_STR_UD : 0));
+}
+
+uint8_t ls7366r_sim::onTransfer(void *ctx, uint8_t mosi){
+    return ((ls7366r_sim*)ctx)->transfer(mosi);
+}
+
+uint32_t ls7366r_sim::readValue(uint8_t reg){
+    switch (reg) {
+        case LS7366R_SIM_MDR0:  return mdr0;
+        case LS7366R_SIM_MDR1:  return mdr1;
+        case LS7366R_SIM_CNTR:  otr = cntr; return otr;
+        case LS7366R_SIM_OTR:   return otr;
+        case LS7366R_SIM_STR: {
+            uint8_t s = str & ~(LS7366R_SIM_STR_CEN | LS7366R_SIM_STR_S);
+            if (!(mdr1 & LS7366R_SIM_MDR1_DISABLE)) s |= LS7366R_SIM_STR_CEN;
+            if (getCounter() < 0) s |= LS7366R_SIM_STR_S;
+            return s;
+        }
+    }
+    return 0;
+}
+
+void ls7366r_sim::writeValue(uint8_t reg, uint32_t value){
+    switch (reg) {
+        case LS7366R_SIM_MDR0:  mdr0 = (uint8_t)value; break;
+        case LS7366R_SIM_MDR1:  mdr1 = (uint8_t)value; cntr &= mask(); break;
+        case LS7366R_SIM_DTR:   dtr = value & mask(); break;
+    }
+}
+
+static int regBytes(uint8_t reg, int width){
+    return (reg == LS7366R_SIM_MDR0 || reg == LS7366R_SIM_MDR1 || reg == LS7366R_SIM_STR) ? 1 : width;
+}
+
+uint8_t ls7366r_sim::transfer(uint8_t mosi){
+    if (byte_index == 0) {
+        // Instruction byte: execute, and set up a read
+        ir = mosi;
+        byte_index = 1;
+        uint8_t reg = ir & LS7366R_SIM_REG_MASK;
+
+        switch (ir & LS7366R_SIM_OP_MASK) {
+            case LS7366R_SIM_OP_CLR:
+                if (reg == LS7366R_SIM_MDR0) mdr0 = 0;
+                else if (reg == LS7366R_SIM_MDR1) mdr1 = 0;
+                else if (reg == LS7366R_SIM_CNTR) cntr = 0;
+                else if (reg == LS7366R_SIM_STR) str = 0;
+                break;
+            case LS7366R_SIM_OP_LOAD:
+                if (reg == LS7366R_SIM_CNTR) cntr = dtr;
+                else if (reg == LS7366R_SIM_OTR) otr = cntr;
+                break;
+            case LS7366R_SIM_OP_RD:
+                shift = readValue(reg);
+                break;
+            case LS7366R_SIM_OP_WR:
+                shift = 0;
+                break;
+        }
+        return 0xFF;
+    }
+
+    uint8_t reg = ir & LS7366R_SIM_REG_MASK;
+    int bytes = regBytes(reg, width());
+    int n = byte_index++;
+    if (n > bytes) {
+        return 0xFF;
+    }
+
+    switch (ir & LS7366R_SIM_OP_MASK) {
+        case LS7366R_SIM_OP_RD:
+            return (uint8_t)(shift >> (8 * (bytes - n)));
+        case LS7366R_SIM_OP_WR:
+            shift = (shift << 8) | mosi;
+            if (n == bytes) {
+                writeValue(reg, shift);
+            }
+            break;
+    }
+    return 0xFF;
+}
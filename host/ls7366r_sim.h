@@ -0,0 +1,63 @@
+/**
+ * @file ls7366r_sim.h
+ * @brief Simulated LS7366R quadrature counter on host_sim pins
+ *
+ * Host only. Decodes A/B in x4 on every pin change (an ideal counter,
+ * no input filter limit) and answers the SPI commands LS7366R_Single
+ * uses through the host SPI stand-in (host/arduino/SPI.h):
+ *
+ * - CLR  MDR0 / MDR1 / CNTR / STR
+ * - RD   MDR0 / MDR1 / CNTR / OTR / STR  (CNTR is copied to OTR first)
+ * - WR   MDR0 / MDR1 / DTR
+ * - LOAD CNTR (from DTR) / OTR (from CNTR)
+ *
+ * Multi-byte registers are 1..4 bytes wide as set in MDR1, MSB first.
+ * MDR0 quadrature modes other than x4 are counted as x4.
+ */
+
+#ifndef _LS7366R_SIM_H
+#define _LS7366R_SIM_H
+
+#include <stdint.h>
+
+class ls7366r_sim{
+    private:
+        int cs_pin;
+        int a_pin;
+        int b_pin;
+
+        uint8_t mdr0;
+        uint8_t mdr1;
+        uint32_t dtr;
+        uint32_t cntr;
+        uint32_t otr;
+        uint8_t str;
+        uint8_t ab;
+
+        uint8_t ir;             // Instruction of the current CS frame
+        int byte_index;         // Bytes exchanged in the current CS frame
+        uint32_t shift;         // Data being read or written
+
+        static void onPin(void *ctx, int pin, int level);
+        static uint8_t onTransfer(void *ctx, uint8_t mosi);
+        uint8_t transfer(uint8_t mosi);
+        int width() const;
+        uint32_t mask() const;
+        uint32_t readValue(uint8_t reg);
+        void writeValue(uint8_t reg, uint32_t value);
+
+    public:
+        /** Creates ls7366r_sim object attached to the given pins
+         *
+         *  @param cs_pin   CS Pin (SPI select, active low)
+         *  @param a_pin    Channel A input
+         *  @param b_pin    Channel B input
+         */
+        ls7366r_sim(int cs_pin, int a_pin, int b_pin);
+        ~ls7366r_sim();
+
+        /** Get the counter as the chip holds it (sign extended from the MDR1 width) */
+        int32_t getCounter() const;
+};
+
+#endif
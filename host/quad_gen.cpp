@@ -0,0 +1,155 @@
+/**
+ * @file quad_gen.cpp
+ * @brief Implementation of the synthetic quadrature generator
+ */
+
+#include "quad_gen.h"
+#include "host_sim.h"
+
+// AB for position & 3, forward order: 00 -> 10 -> 11 -> 01
+static const uint8_t quad_seq[4] = { 0x0, 0x2, 0x3, 0x1 };
+
+quad_gen::quad_gen(int pin_a, int pin_b, int pin_z, uint32_t seed)
+    : pin_a(pin_a), pin_b(pin_b), pin_z(pin_z), rng(seed ? seed : 1),
+      period_q8(0), slot_q8(0), jitter_ns(0), glitch_q16(0), glitch_ns(0),
+      reverse_q16(0), cpr(0), position(0), dir(1), running(false), glitch_pin(-1),
+      edges(0), glitches(0), reversals(0), index_pulses(0), lost_events(0) {
+    setRate(100000);
+    drive();
+}
+
+quad_gen::~quad_gen(){
+    stop();
+}
+
+uint32_t quad_gen::random(){
+    // xorshift32
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+bool quad_gen::chance(uint16_t q16){
+    return q16 && (random() & 0xFFFF) < q16;
+}
+
+void quad_gen::setRate(uint32_t edges_per_s){
+    if (edges_per_s == 0) {
+        edges_per_s = 1;
+    }
+    period_q8 = (1000000000ULL << 8) / edges_per_s;
+}
+
+void quad_gen::setGlitches(uint16_t probability_q16, uint32_t width_ns){
+    glitch_q16 = probability_q16;
+    glitch_ns = width_ns ? width_ns : 1;
+}
+
+void quad_gen::drive(){
+    uint8_t ab = quad_seq[position & 3];
+    host_sim::write(pin_a, ab >> 1);
+    host_sim::write(pin_b, ab & 1);
+
+    if (pin_z >= 0) {
+        bool at_index = cpr && (position % (int64_t)cpr) == 0;
+        if (at_index && !host_sim::read(pin_z)) {
+            index_pulses++;
+        }
+        host_sim::write(pin_z, at_index ? 1 : 0);
+    }
+}
+
+bool quad_gen::scheduleEdge(){
+    slot_q8 += period_q8;
+    uint64_t at = slot_q8 >> 8;
+
+    uint32_t jitter = jitter_ns;
+    uint32_t half = (uint32_t)(period_q8 >> 9);
+    if (jitter >= half) {
+        jitter = half ? half - 1 : 0;
+    }
+    if (jitter) {
+        int64_t offset = (int64_t)(random() % (2 * jitter + 1)) - jitter;
+        at = (uint64_t)((int64_t)at + offset);
+    }
+
+    if (!host_sim::schedule(at, onEdge, this)) {
+        // No edge in flight: the generator has stopped
+        running = false;
+        lost_events++;
+        return false;
+    }
+    return true;
+}
+
+void quad_gen::onEdge(void *ctx){
+    quad_gen *g = (quad_gen*)ctx;
+
+    if (g->chance(g->reverse_q16)) {
+        g->dir = (int8_t)-g->dir;
+        g->reversals++;
+    }
+
+    uint8_t before = quad_seq[g->position & 3];
+    g->position += g->dir;
+    g->edges++;
+    g->drive();
+
+    if (g->chance(g->glitch_q16) && g->glitch_pin < 0) {
+        // Pulse the channel that did not switch, a quarter period later
+        uint8_t changed = before ^ quad_seq[g->position & 3];
+        g->glitch_pin = (changed & 0x2) ? g->pin_b : g->pin_a;
+        if (!host_sim::schedule(host_sim::nanos() + (g->period_q8 >> 10), onGlitch, g)) {
+            g->glitch_pin = -1;
+            g->lost_events++;
+        }
+    }
+
+    g->scheduleEdge();
+}
+
+void quad_gen::onGlitch(void *ctx){
+    quad_gen *g = (quad_gen*)ctx;
+
+    uint32_t width = g->glitch_ns;
+    uint32_t quarter = (uint32_t)(g->period_q8 >> 10);
+    if (width >= quarter) {
+        width = quarter ? quarter - 1 : 1;
+    }
+
+    if (!host_sim::schedule(host_sim::nanos() + width, onGlitchEnd, g)) {
+        // Could not end the pulse later: leave it out
+        g->glitch_pin = -1;
+        g->lost_events++;
+        return;
+    }
+    host_sim::write(g->glitch_pin, !host_sim::read(g->glitch_pin));
+    g->glitches++;
+}
+
+void quad_gen::onGlitchEnd(void *ctx){
+    quad_gen *g = (quad_gen*)ctx;
+    g->glitch_pin = -1;
+    g->drive();
+}
+
+bool quad_gen::start(){
+    if (running) {
+        return true;
+    }
+    running = true;
+    slot_q8 = host_sim::nanos() << 8;
+    return scheduleEdge();
+}
+
+void quad_gen::stop(){
+    running = false;
+    host_sim::cancel(onEdge, this);
+    host_sim::cancel(onGlitch, this);
+    host_sim::cancel(onGlitchEnd, this);
+    if (glitch_pin >= 0) {
+        glitch_pin = -1;
+        drive();
+    }
+}
@@ -0,0 +1,149 @@
+/**
+ * @file quad_gen.h
+ * @brief Synthetic A/B(/Z) quadrature generator on host_sim virtual time
+ *
+ * Host only. Drives quadrature edges onto host_sim pins from scheduled
+ * events, so anything listening on the pins (abi_encoder_arduino
+ * interrupts through host/arduino, ls7366r_sim) sees them interleaved
+ * with driver delays. Everything random comes from one seeded xorshift
+ * generator: the same seed and settings give the same waveform.
+ *
+ * Shaping (all optional, changeable while running):
+ * - rate:      edges per second, exact on average (no drift)
+ * - jitter:    each edge moved by up to +/- jitter_ns from its slot
+ * - glitches:  short pulses on the idle channel; they do not move the
+ *              position, a decoder that counts them is wrong
+ * - reversals: the direction flips at random edges
+ * - index:     Z is high for one quadrature state per cpr counts
+ *
+ * getPosition() is the ground truth in x4 counts.
+ *
+ * Edges and glitches are host_sim events. If the event queue is full
+ * (HOST_SIM_EVENTS), a glitch is left out and an edge stops the
+ * generator; both are counted in getLostEvents().
+ */
+
+#ifndef _QUAD_GEN_H
+#define _QUAD_GEN_H
+
+#include <stdint.h>
+
+class quad_gen{
+    private:
+        int pin_a;
+        int pin_b;
+        int pin_z;
+
+        uint32_t rng;
+
+        uint64_t period_q8;         // ns per edge, Q8
+        uint64_t slot_q8;           // Nominal time of the next edge, ns Q8
+        uint32_t jitter_ns;
+        uint16_t glitch_q16;        // Probability per edge
+        uint32_t glitch_ns;
+        uint16_t reverse_q16;       // Probability per edge
+        uint32_t cpr;               // Index period (0 = no index)
+
+        int64_t position;
+        int8_t dir;
+        bool running;
+        int glitch_pin;             // Pin pulsed by the pending glitch
+
+        uint64_t edges;
+        uint32_t glitches;
+        uint32_t reversals;
+        uint32_t index_pulses;
+        uint32_t lost_events;       // host_sim::schedule() found the queue full
+
+        uint32_t random();
+        bool chance(uint16_t q16);
+        void drive();
+        bool scheduleEdge();
+        static void onEdge(void *ctx);
+        static void onGlitch(void *ctx);
+        static void onGlitchEnd(void *ctx);
+
+    public:
+        /** Creates quad_gen object driving the given pins
+         *
+         *  @param pin_a    Channel A
+         *  @param pin_b    Channel B
+         *  @param pin_z    Index (-1 = none)
+         *  @param seed     Random seed (0 is replaced by 1)
+         */
+        quad_gen(int pin_a, int pin_b, int pin_z = -1, uint32_t seed = 1);
+        ~quad_gen();
+
+        /** Set the edge rate (takes effect from the next edge)
+         *
+         *  @param edges_per_s  x4 edges per second
+         */
+        void setRate(uint32_t edges_per_s);
+
+        /** Move each edge by a random amount
+         *
+         *  @param jitter_ns    Maximum offset either way (kept below half a period)
+         */
+        void setJitter(uint32_t jitter_ns) { this->jitter_ns = jitter_ns; }
+
+        /** Add glitches on the channel that is not switching
+         *
+         *  @param probability_q16  Chance per edge (Q16, 65535 = every edge)
+         *  @param width_ns         Pulse width (kept below a quarter period)
+         */
+        void setGlitches(uint16_t probability_q16, uint32_t width_ns);
+
+        /** Reverse the direction at random edges
+         *
+         *  @param probability_q16  Chance per edge (Q16)
+         */
+        void setReversals(uint16_t probability_q16) { reverse_q16 = probability_q16; }
+
+        /** Set the direction
+         *
+         *  @param forward  true to count up
+         */
+        void setDirection(bool forward) { dir = forward ? 1 : -1; }
+
+        /** Pulse Z once per revolution
+         *
+         *  @param cpr  x4 counts per revolution (0 = Z stays low)
+         */
+        void setIndex(uint32_t cpr) { this->cpr = cpr; }
+
+        /** Start generating from the current virtual time
+         *
+         *  @return     false if the first edge could not be scheduled
+         */
+        bool start();
+
+        /** Stop now
+         *
+         *  Cancels the pending edge and glitch events and ends a glitch in
+         *  progress; A/B/Z keep the levels of the current position.
+         */
+        void stop();
+
+        /** true between start() and stop(), false once an edge was lost */
+        bool isRunning() const { return running; }
+
+        /** Ground truth position (x4 counts) */
+        int64_t getPosition() const { return position; }
+
+        /** Edges generated (both directions) */
+        uint64_t getEdges() const { return edges; }
+
+        /** Glitch pulses generated */
+        uint32_t getGlitches() const { return glitches; }
+
+        /** Direction reversals generated */
+        uint32_t getReversals() const { return reversals; }
+
+        /** Index pulses generated */
+        uint32_t getIndexPulses() const { return index_pulses; }
+
+        /** Edge or glitch events dropped because the host_sim queue was full */
+        uint32_t getLostEvents() const { return lost_events; }
+};
+
+#endif
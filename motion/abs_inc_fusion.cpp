@@ -0,0 +1,83 @@
+/**
+ * @file abs_inc_fusion.cpp
+ * @brief Implementation of absolute + incremental position fusion
+ */
+
+#include "abs_inc_fusion.h"
+
+abs_inc_fusion::abs_inc_fusion(uint32_t cpr, uint32_t tolerance, bool invert)
+    : offset(0), count_ext(0), last_count(0),
+      cpr(cpr ? cpr : 1), tolerance(tolerance), invert(invert),
+      auto_correct(true), aligned(false),
+      last_error(0), slips(0), skipped(0) {
+}
+
+uint32_t abs_inc_fusion::absToCounts(uint16_t raw) const{
+    // 14-bit angle -> counts, rounded, within one turn
+    uint32_t counts = (uint32_t)((((uint64_t)(raw & 0x3FFF) * cpr) + 8192) >> 14);
+    return counts >= cpr ? counts - cpr : counts;
+}
+
+int32_t abs_inc_fusion::turnError(uint16_t raw, int64_t position) const{
+    // Shortest way round the turn: [-cpr/2, cpr/2)
+    int64_t diff = ((int64_t)absToCounts(raw) - position) % (int64_t)cpr;
+    if (diff < 0) {
+        diff += cpr;
+    }
+    if (diff >= (int64_t)(cpr - cpr / 2)) {
+        diff -= cpr;
+    }
+    return (int32_t)diff;
+}
+
+bool abs_inc_fusion::plausible(int64_t moved) const{
+    // Half a turn or more between two syncs a few hundred us apart is a
+    // glitch or a wrap we cannot place, not motion
+    return (uint64_t)(moved < 0 ? -moved : moved) < cpr / 2;
+}
+
+abs_inc_fusion_status abs_inc_fusion::align(uint16_t raw, int32_t count_before, int32_t count_after){
+    int32_t moved = (int32_t)((uint32_t)count_after - (uint32_t)count_before);
+    if (!plausible(moved)) {
+        skipped++;
+        return ABS_INC_FUSION_SKIPPED;
+    }
+
+    // The angle belongs to the middle of the read
+    count_ext = 0;
+    last_count = count_before;
+    int64_t mid = moved / 2;
+    offset = (int64_t)absToCounts(raw) - (invert ? -mid : mid);
+
+    last_error = 0;
+    aligned = true;
+    return ABS_INC_FUSION_OK;
+}
+
+abs_inc_fusion_status abs_inc_fusion::crossCheck(uint16_t raw, int32_t count_before, int32_t count_after){
+    if (!aligned) {
+        return ABS_INC_FUSION_NOT_ALIGNED;
+    }
+
+    int64_t before = getPosition(count_before);
+    int64_t after = getPosition(count_after);
+    int64_t moved = after - before;
+    if (!plausible(moved)) {
+        skipped++;
+        return ABS_INC_FUSION_SKIPPED;
+    }
+
+    // The angle was taken somewhere between the two syncs: compare with the
+    // midpoint and allow for half the motion on top of the tolerance
+    uint64_t spread = ((uint64_t)(moved < 0 ? -moved : moved) + 1) / 2;
+    last_error = turnError(raw, before + moved / 2);
+    if ((uint64_t)(last_error < 0 ? -last_error : last_error) <= tolerance + spread) {
+        return ABS_INC_FUSION_OK;
+    }
+
+    slips++;
+    if (auto_correct) {
+        offset += last_error;
+    }
+    return ABS_INC_FUSION_SLIP;
+}
@@ -0,0 +1,176 @@
+/**
+ * @file abs_inc_fusion.h
+ * @brief Absolute (AS5047P) + incremental (LS7366R) position fusion
+ *
+ * The AS5047P ABI output counted by an LS7366R gives a cheap, fast
+ * position with no absolute reference; the AS5047P SPI angle gives the
+ * reference but costs a full bus transaction. This class takes the
+ * absolute angle once to place the incremental count on the sensor's
+ * turn, then serves the position from the count alone:
+ *
+ *   position = count (unwrapped to 64 bit) + offset
+ *
+ * in incremental counts, with 0 at the AS5047P zero. crossCheck() compares
+ * the two again from time to time. A difference beyond the tolerance is
+ * slip (missed ABI edges, noise on A/B): it is counted and, with
+ * auto-correct on, removed by moving the offset.
+ *
+ * The angle read and the count are not taken at the same instant, so
+ * the check uses the counts just before and just after the angle read,
+ * compares the angle with their midpoint and widens the tolerance by half
+ * the motion in between. It still works at speed; it is only skipped when
+ * the two counts are half a turn or more apart, which is not motion, or
+ * when the angle frame had a parity error or the error flag set.
+ *
+ * Sources (any types with these members, see the template overloads):
+ * - sensor:  readAngleCorrected(), getParityErrors() / getErrorFrames()  (as5047p_arduino)
+ * - counter: sync() / getCount()               (LS7366R_Single)
+ */
+
+#ifndef _ABS_INC_FUSION_H
+#define _ABS_INC_FUSION_H
+
+#include <stdint.h>
+
+/** Default slip tolerance (incremental counts) */
+#define ABS_INC_FUSION_TOLERANCE    4
+
+/** Result of align() / crossCheck() */
+enum abs_inc_fusion_status{
+    ABS_INC_FUSION_OK = 0,          ///< Sources agree (or aligned)
+    ABS_INC_FUSION_SLIP,            ///< Disagreement beyond the tolerance
+    ABS_INC_FUSION_SKIPPED,         ///< Angle frame faulted, or counts around it >= half a turn apart
+    ABS_INC_FUSION_NOT_ALIGNED      ///< crossCheck() before align()
+};
+
+class abs_inc_fusion{
+    private:
+        int64_t offset;             // Position - unwrapped count
+        int64_t count_ext;          // Unwrapped count
+        int32_t last_count;
+
+        uint32_t cpr;               // Incremental counts per turn
+        uint32_t tolerance;
+        bool invert;                // Counter runs against the angle
+        bool auto_correct;
+        bool aligned;
+
+        int32_t last_error;         // Absolute - incremental at the last check
+        uint32_t slips;             // Checks beyond the tolerance
+        uint32_t skipped;           // Checks skipped for a faulted angle or implausible counts
+
+        uint32_t absToCounts(uint16_t raw) const;
+        int32_t turnError(uint16_t raw, int64_t position) const;
+        bool plausible(int64_t moved) const;
+
+    public:
+        /** Creates abs_inc_fusion object with specific content.
+         *
+         *  @param cpr          Incremental counts per turn (ABI pulses x4)
+         *  @param tolerance    Allowed difference before a check reports slip (counts)
+         *  @param invert       true if the count decreases as the angle increases
+         */
+        abs_inc_fusion(uint32_t cpr, uint32_t tolerance = ABS_INC_FUSION_TOLERANCE, bool invert = false);
+
+        /** Correct slip automatically in crossCheck() (default on)
+         *
+         *  @param enable   false to only count and report slip
+         */
+        void setAutoCorrect(bool enable) { auto_correct = enable; }
+
+        /** Place the count on the absolute turn
+         *
+         *  @param raw          AS5047P 14-bit angle
+         *  @param count_before Counter value just before the angle read
+         *  @param count_after  Counter value just after the angle read
+         *  @return             ABS_INC_FUSION_OK, or _SKIPPED if the axis moved too much
+         */
+        abs_inc_fusion_status align(uint16_t raw, int32_t count_before, int32_t count_after);
+
+        /** Compare the absolute angle with the fused position
+         *
+         *  @param raw          AS5047P 14-bit angle
+         *  @param count_before Counter value just before the angle read
+         *  @param count_after  Counter value just after the angle read
+         *  @return             Result of the check
+         */
+        abs_inc_fusion_status crossCheck(uint16_t raw, int32_t count_before, int32_t count_after);
+
+        /** Get the position for a counter value (hot path)
+         *
+         *  Call at least once per 2^31 counts so the 32-bit counter
+         *  unwraps correctly.
+         *
+         *  @param count    Counter value (LS7366R_Single::getCount())
+         *  @return         Position (incremental counts, 0 at the AS5047P zero)
+         */
+        int64_t getPosition(int32_t count){
+            count_ext += (int32_t)((uint32_t)count - (uint32_t)last_count);
+            last_count = count;
+            return invert ? offset - count_ext : offset + count_ext;
+        }
+
+        /** Get the position within the turn
+         *
+         *  @param count    Counter value
+         *  @return         0 .. cpr - 1
+         */
+        uint32_t getTurnPosition(int32_t count){
+            int64_t turn = getPosition(count) % (int64_t)cpr;
+            return (uint32_t)(turn < 0 ? turn + cpr : turn);
+        }
+
+        /** true once align() succeeded */
+        bool isAligned() const { return aligned; }
+
+        /** Absolute - incremental at the last check (counts) */
+        int32_t getLastError() const { return last_error; }
+
+        /** Checks that found slip */
+        uint32_t getSlips() const { return slips; }
+
+        /** Checks skipped for a faulted angle frame or implausible counts around it */
+        uint32_t getSkipped() const { return skipped; }
+
+        /** Align from a sensor and a counter
+         *
+         *  @param sensor   Provides readAngleCorrected(), getParityErrors() and getErrorFrames()
+         *  @param counter  Provides sync() and getCount()
+         */
+        template <class S, class C>
+        abs_inc_fusion_status align(S &sensor, C &counter){
+            uint32_t faults = sensor.getParityErrors() + sensor.getErrorFrames();
+            counter.sync();
+            int32_t before = counter.getCount();
+            uint16_t raw = sensor.readAngleCorrected();
+            counter.sync();
+            if (sensor.getParityErrors() + sensor.getErrorFrames() != faults) {
+                skipped++;
+                return ABS_INC_FUSION_SKIPPED;
+            }
+            return align(raw, before, counter.getCount());
+        }
+
+        /** Cross-check from a sensor and a counter
+         *
+         *  A faulted angle frame is skipped, not taken as slip.
+         *
+         *  @param sensor   Provides readAngleCorrected(), getParityErrors() and getErrorFrames()
+         *  @param counter  Provides sync() and getCount()
+         */
+        template <class S, class C>
+        abs_inc_fusion_status crossCheck(S &sensor, C &counter){
+            uint32_t faults = sensor.getParityErrors() + sensor.getErrorFrames();
+            counter.sync();
+            int32_t before = counter.getCount();
+            uint16_t raw = sensor.readAngleCorrected();
+            counter.sync();
+            if (sensor.getParityErrors() + sensor.getErrorFrames() != faults) {
+                skipped++;
+                return ABS_INC_FUSION_SKIPPED;
+            }
+            return crossCheck(raw, before, counter.getCount());
+        }
+};
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * @file alpha_beta_tracker.cpp
+ * @brief Implementation of fixed-point alpha-beta(-gamma) tracker
+ */
+
+#include "alpha_beta_tracker.h"
+
+#define Q16_ONE     ((int64_t)1 << 16)
+
+static int32_t saturate32(int64_t v){
+    if (v > INT32_MAX) return INT32_MAX;
+    if (v < -INT32_MAX) return -INT32_MAX;
+    return (int32_t)v;
+}
+
+alpha_beta_tracker::alpha_beta_tracker(uint32_t period_us, uint8_t wrap_bits, bool track_accel)
+    : x(0), v(0), a(0), alpha(0), beta(0), gamma2(0),
+      period_us(period_us < ALPHA_BETA_TRACKER_MIN_PERIOD_US ? ALPHA_BETA_TRACKER_MIN_PERIOD_US : period_us),
+      last_us(0), wrap_bits(wrap_bits), track_accel(track_accel), primed(false) {
+    // 2^32 / period_us fits 32 bits from 2 us up
+    inv_period = (uint32_t)(((uint64_t)1 << 32) / this->period_us);
+    setFadingMemory(ALPHA_BETA_TRACKER_THETA_DEFAULT);
+}
+
+void alpha_beta_tracker::setGains(uint32_t alpha_q16, uint32_t beta_q16, uint32_t gamma_q16){
+    alpha = alpha_q16;
+    beta = beta_q16;
+    gamma2 = track_accel ? gamma_q16 * 2 : 0;
+}
+
+void alpha_beta_tracker::setFadingMemory(uint16_t theta_q16){
+    // Fading-memory gains (theta = discount factor per sample)
+    //  alpha-beta:        a = 1 - t^2,  b = (1 - t)^2
+    //  alpha-beta-gamma:  a = 1 - t^3,  b = 1.5 (1 - t^2)(1 - t),  g = 0.5 (1 - t)^3
+    uint64_t t = theta_q16;
+    uint64_t t2 = (t * t) >> 16;
+    uint64_t t3 = (t2 * t) >> 16;
+    uint64_t om = Q16_ONE - t;
+    uint64_t om2 = (om * om) >> 16;
+
+    if (track_accel) {
+        uint64_t om3 = (om2 * om) >> 16;
+        setGains((uint32_t)(Q16_ONE - t3),
+                 (uint32_t)((3 * (Q16_ONE - t2) * om) >> 17),
+                 (uint32_t)(om3 >> 1));
+    } else {
+        setGains((uint32_t)(Q16_ONE - t2), (uint32_t)om2);
+    }
+}
+
+void alpha_beta_tracker::reset(int64_t z, uint32_t t_us){
+    x = z * Q16_ONE;
+    v = 0;
+    a = 0;
+    last_us = t_us;
+    primed = true;
+}
+
+void alpha_beta_tracker::update(int64_t z, uint32_t t_us){
+    uint32_t dt_us = t_us - last_us;
+
+    if (!primed || dt_us > period_us * ALPHA_BETA_TRACKER_MAX_GAP) {
+        reset(z, t_us);
+        return;
+    }
+    last_us = t_us;
+
+    // dt in ticks (Q16)
+    int64_t dt = (int64_t)(((uint64_t)dt_us * inv_period) >> 16);
+
+    // Predict
+    int64_t dv = (a * dt) >> 16;
+    x += ((v + (dv >> 1)) * dt) >> 16;
+    v += dv;
+
+    // Residual, wrapped to +/- half a turn for modular inputs
+    int64_t r = z * Q16_ONE - x;
+    if (wrap_bits) {
+        int64_t turn = (int64_t)1 << (wrap_bits + 16);
+        r = ((r + (turn >> 1)) & (turn - 1)) - (turn >> 1);
+    }
+
+    // Correct
+    x += (r * alpha) >> 16;
+    v += (r * beta) >> 16;
+    a += (r * gamma2) >> 16;
+}
+
+int32_t alpha_beta_tracker::getVelocity() const{
+    // counts/tick Q16 -> counts/s Q8
+    return saturate32(((v * 1000000) / period_us) >> 8);
+}
+
+int32_t alpha_beta_tracker::getAcceleration() const{
+    // counts/tick^2 Q16 -> counts/s^2
+    int64_t per_s = (a * 1000000) / period_us;
+    return saturate32(((per_s * 1000000) / period_us) >> 16);
+}
@@ -0,0 +1,135 @@
+/**
+ * @file alpha_beta_tracker.h
+ * @brief Fixed-point alpha-beta(-gamma) tracking filter for polled encoder counts
+ *
+ * Smooths timestamped position samples from any of the drivers into
+ * position, velocity and (optionally) acceleration estimates:
+ * - LS7366R_Single::getCount() / getSyncMicros()
+ * - abi_encoder_arduino::getEdgeSnapshot()
+ * - as5047p_arduino ANGLECOM (wrap_bits = 14)
+ *
+ * Internally time is measured in ticks of the nominal sample period, so
+ * the gains are dimensionless and the update needs no division:
+ *
+ *   predict:  x += (v + a*dt/2)*dt,  v += a*dt
+ *   correct:  r = z - x
+ *             x += alpha*r,  v += beta*r,  a += 2*gamma*r
+ *
+ * dt is the measured sample interval in ticks, so jittered or skipped
+ * samples are predicted correctly. The gains are applied once per sample
+ * and are not scaled with dt: they set the response in samples, not in
+ * seconds. A tracker built for another period needs its gains (or theta)
+ * retuned to keep the same bandwidth in Hz.
+ *
+ * Position, velocity and acceleration are 64-bit Q16 values; the
+ * per-sample cost is a handful of integer multiplies with no floats, no
+ * heap and no branches on the data.
+ *
+ * With wrap_bits > 0 the input is taken modulo 2^wrap_bits and the
+ * residual is wrapped to +/- half a turn, so the filter tracks the
+ * unwrapped (multi-turn) position across the 16383 -> 0 rollover.
+ */
+
+#ifndef _ALPHA_BETA_TRACKER_H
+#define _ALPHA_BETA_TRACKER_H
+
+#include <stdint.h>
+
+/** Default fading-memory factor (Q16, 0.75) */
+#define ALPHA_BETA_TRACKER_THETA_DEFAULT    0xC000
+
+/** Shortest sample period: one tick must span at least 2 us for the Q16 dt */
+#define ALPHA_BETA_TRACKER_MIN_PERIOD_US    2
+
+/** Samples more than this many periods apart restart the filter */
+#define ALPHA_BETA_TRACKER_MAX_GAP          16
+
+class alpha_beta_tracker{
+    private:
+        int64_t x;              // Position (counts, Q16, unwrapped)
+        int64_t v;              // Velocity (counts/tick, Q16)
+        int64_t a;              // Acceleration (counts/tick^2, Q16)
+
+        uint32_t alpha;         // Gains (Q16)
+        uint32_t beta;
+        uint32_t gamma2;        // 2*gamma
+
+        uint32_t period_us;     // Nominal sample period (one tick)
+        uint32_t inv_period;    // 2^32 / period_us
+        uint32_t last_us;
+
+        uint8_t wrap_bits;
+        bool track_accel;
+        bool primed;
+
+    public:
+        /** Creates alpha_beta_tracker object with specific content.
+         *
+         *  @param period_us    Nominal sample period (us), clamped to at
+         *                      least ALPHA_BETA_TRACKER_MIN_PERIOD_US
+         *  @param wrap_bits    Input wraps at 2^wrap_bits (0 = no wrap, 14 = AS5047P)
+         *  @param track_accel  true for alpha-beta-gamma, false for alpha-beta
+         */
+        alpha_beta_tracker(uint32_t period_us, uint8_t wrap_bits = 0, bool track_accel = false);
+
+        /** Set the filter gains directly.
+         *
+         *  Per sample: the same gains track twice as fast in seconds at
+         *  half the period.
+         *
+         *  @param alpha_q16    Position gain (Q16)
+         *  @param beta_q16     Velocity gain (Q16)
+         *  @param gamma_q16    Acceleration gain (Q16, ignored for alpha-beta)
+         */
+        void setGains(uint32_t alpha_q16, uint32_t beta_q16, uint32_t gamma_q16 = 0);
+
+        /** Set critically damped (fading-memory) gains.
+         *
+         *  Larger theta means heavier smoothing and slower response.
+         *  theta is the discount per sample, so the memory in seconds
+         *  scales with the period.
+         *
+         *  @param theta_q16    Fading-memory factor in [0, 1) (Q16)
+         */
+        void setFadingMemory(uint16_t theta_q16);
+
+        /** Restart the filter at a measured position with zero velocity
+         *
+         *  @param z        Position (counts)
+         *  @param t_us     Sample time
+         */
+        void reset(int64_t z, uint32_t t_us);
+
+        /** Feed one sample.
+         *
+         *  @param z        Measured position (counts, or raw angle if wrapping)
+         *  @param t_us     Sample time (micros())
+         */
+        void update(int64_t z, uint32_t t_us);
+
+        /** Get the smoothed position
+         *
+         *  @return     Position (counts, unwrapped)
+         */
+        int64_t getPosition() const { return x >> 16; }
+
+        /** Get the smoothed position with fraction
+         *
+         *  @return     Position (counts, Q16, unwrapped)
+         */
+        int64_t getPositionQ16() const { return x; }
+
+        /** Get the smoothed velocity
+         *
+         *  @return     Velocity (counts/s, Q24.8)
+         */
+        int32_t getVelocity() const;
+
+        /** Get the smoothed acceleration
+         *
+         *  @return     Acceleration (counts/s^2), 0 for alpha-beta
+         */
+        int32_t getAcceleration() const;
+};
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file mt_velocity.cpp
+ * @brief Implementation of M/T-method velocity estimator
+ */
+
+#include "mt_velocity.h"
+
+// counts/us -> counts/s in Q(MT_VELOCITY_FRAC_BITS)
+#define MT_VELOCITY_SCALE   ((int64_t)1000000 << MT_VELOCITY_FRAC_BITS)
+
+static int32_t saturate32(int64_t v){
+    if (v > INT32_MAX) return INT32_MAX;
+    if (v < -INT32_MAX) return -INT32_MAX;
+    return (int32_t)v;
+}
+
+mt_velocity::mt_velocity(uint32_t min_window_us, uint32_t max_window_us, uint32_t min_counts)
+    : ref_count(0), ref_edge_us(0), last_count(0), last_change_us(0),
+      velocity(0), primed(false),
+      min_window_us(min_window_us), max_window_us(max_window_us), min_counts(min_counts) {
+}
+
+void mt_velocity::reset(int64_t count, uint32_t edge_us){
+    ref_count = count;
+    ref_edge_us = edge_us;
+    last_count = count;
+    last_change_us = edge_us;
+    velocity = 0;
+    primed = true;
+}
+
+int32_t mt_velocity::updateEdge(int64_t count, uint32_t edge_us, uint32_t now_us){
+    if (!primed) {
+        reset(count, edge_us);
+        return velocity;
+    }
+
+    int64_t m = count - ref_count;          // counts in window
+    uint32_t t = edge_us - ref_edge_us;     // first edge -> last edge
+    uint32_t window = now_us - ref_edge_us; // first edge -> now
+    uint32_t idle = now_us - edge_us;       // last edge -> now
+
+    // Close the window once it holds enough counts or enough time
+    if (m != 0 && t > 0) {
+        uint64_t am = (uint64_t)(m < 0 ? -m : m);
+        if (am >= min_counts || window >= min_window_us) {
+            // Keep m * SCALE inside int64
+            if (am > (uint64_t)(INT64_MAX / MT_VELOCITY_SCALE)) {
+                velocity = m < 0 ? -INT32_MAX : INT32_MAX;
+            } else {
+                velocity = saturate32((m * MT_VELOCITY_SCALE) / (int64_t)t);
+            }
+            ref_count = count;
+            ref_edge_us = edge_us;
+        }
+    }
+
+    // No edge for `idle` us means |v| < 1 count / idle
+    if (idle >= max_window_us) {
+        velocity = 0;
+        // Keep the reference edge within max_window_us so T cannot wrap
+        // when motion resumes after a long standstill
+        if (m == 0) {
+            ref_edge_us = now_us - max_window_us;
+        }
+    } else if (idle > 0) {
+        int32_t bound = saturate32(MT_VELOCITY_SCALE / (int64_t)idle);
+        if (velocity > bound) {
+            velocity = bound;
+        } else if (velocity < -bound) {
+            velocity = -bound;
+        }
+    }
+
+    return velocity;
+}
+
+int32_t mt_velocity::updateSnapshot(int64_t count, uint32_t sample_us){
+    if (!primed) {
+        reset(count, sample_us);
+        return velocity;
+    }
+
+    if (count != last_count) {
+        last_count = count;
+        last_change_us = sample_us;
+    }
+
+    return updateEdge(count, last_change_us, sample_us);
+}
+
+int32_t mt_velocity::getTurnsPerSecond(uint16_t spr) const{
+    if (spr == 0) {
+        return 0;
+    }
+    return saturate32(((int64_t)velocity << (16 - MT_VELOCITY_FRAC_BITS)) / spr);
+}
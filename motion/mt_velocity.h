@@ -0,0 +1,103 @@
+/**
+ * @file mt_velocity.h
+ * @brief M/T-method velocity estimator for quadrature sources
+ *
+ * Combines the number of counts in a window (M) with the time elapsed
+ * between the first and the last edge of that window (T). At high speed
+ * the window holds many counts and the result matches a plain count
+ * difference; at low speed the edge-to-edge time keeps the estimate exact
+ * down to one count per window, and the time since the last edge bounds
+ * it on the way to standstill.
+ *
+ * All arithmetic is integer. Velocity is returned in counts/s as a signed
+ * fixed-point value with MT_VELOCITY_FRAC_BITS fractional bits.
+ *
+ * Sources:
+ * - abi_encoder_arduino::getEdgeSnapshot()                -> updateEdge()
+ * - LS7366R_Single::getCount() / getSyncMicros()          -> updateSnapshot()
+ *
+ * Timestamps are micros() values; wrap-around is handled by unsigned
+ * subtraction.
+ */
+
+#ifndef _MT_VELOCITY_H
+#define _MT_VELOCITY_H
+
+#include <stdint.h>
+
+/** Fractional bits of the velocity value (counts/s) */
+#define MT_VELOCITY_FRAC_BITS       8
+
+/** Default window limits */
+#define MT_VELOCITY_MIN_WINDOW_US   1000    ///< Close a window no earlier than this
+#define MT_VELOCITY_MAX_WINDOW_US   200000  ///< No edge for this long = standstill
+#define MT_VELOCITY_MIN_COUNTS      4       ///< Close a window early once this many counts are in
+
+class mt_velocity{
+    private:
+        int64_t ref_count;        // Count at the first edge of the window
+        uint32_t ref_edge_us;     // Timestamp of the first edge of the window
+
+        int64_t last_count;       // Snapshot sources: count of the previous sample
+        uint32_t last_change_us;  // Snapshot sources: sample time of the last count change
+
+        int32_t velocity;         // counts/s, Q(MT_VELOCITY_FRAC_BITS)
+        bool primed;
+
+        uint32_t min_window_us;
+        uint32_t max_window_us;
+        uint32_t min_counts;
+
+    public:
+        /** Creates mt_velocity object with specific content.
+         *
+         *  @param min_window_us    Minimum window length (us)
+         *  @param max_window_us    Time without edges after which velocity is zero (us)
+         *  @param min_counts       Counts that close a window before min_window_us
+         */
+        mt_velocity(uint32_t min_window_us = MT_VELOCITY_MIN_WINDOW_US,
+                    uint32_t max_window_us = MT_VELOCITY_MAX_WINDOW_US,
+                    uint32_t min_counts = MT_VELOCITY_MIN_COUNTS);
+
+        /** Restart the estimator at a known count
+         *
+         *  @param count    Current count
+         *  @param edge_us  Timestamp of the edge that produced count
+         */
+        void reset(int64_t count, uint32_t edge_us);
+
+        /** Update from an edge-timestamped source
+         *
+         *  @param count    Current count
+         *  @param edge_us  Timestamp of the edge that produced count
+         *  @param now_us   Current time
+         *  @return         Velocity (counts/s, Q(MT_VELOCITY_FRAC_BITS))
+         */
+        int32_t updateEdge(int64_t count, uint32_t edge_us, uint32_t now_us);
+
+        /** Update from a timestamped count snapshot (no edge timing)
+         *
+         *  The edge time is taken as the first sample at which the count
+         *  changed, so T carries up to one sample period of error.
+         *
+         *  @param count        Sampled count
+         *  @param sample_us    Timestamp of the sample
+         *  @return             Velocity (counts/s, Q(MT_VELOCITY_FRAC_BITS))
+         */
+        int32_t updateSnapshot(int64_t count, uint32_t sample_us);
+
+        /** Get the last velocity
+         *
+         *  @return     Velocity (counts/s, Q(MT_VELOCITY_FRAC_BITS))
+         */
+        int32_t getVelocity() const { return velocity; }
+
+        /** Get the last velocity in turns/s
+         *
+         *  @param spr  Steps per revolution
+         *  @return     Velocity (turns/s, Q16.16)
+         */
+        int32_t getTurnsPerSecond(uint16_t spr) const;
+};
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * @file position_source.h
+ * @brief Common position snapshot and static (CRTP) interface for all encoder drivers
+ *
+ * The drivers each have their own read API:
+ *
+ *   LS7366R_Single        sync() / getCount() / getSyncMicros()
+ *   LS7366R               sync() / left() / right()
+ *   abi_encoder_*         getEdgeSnapshot() / getSPR() / getIllegalTransitions()
+ *   as5047p_*             readAnglePipelined() / getAngleMicros() / getParityErrors() / getErrorFrames()
+ *
+ * The adapters below present all of them as a position_source: one
+ * sample(&snapshot) call filling a position_snapshot. Generic code
+ * (samplers, filters, loggers) takes any position_source as a template
+ * parameter:
+ *
+ *   template <class S>
+ *   void log(position_source<S> &src){
+ *       position_snapshot snap;
+ *       if (src.sample(&snap)) { ... }
+ *   }
+ *
+ * Everything is resolved at compile time: no virtual functions, and the
+ * adapter calls inline down to the driver calls they wrap.
+ *
+ * Adapters hold a reference to the driver and are cheap to create:
+ *
+ *   counter_position<LS7366R_Single> enc1_pos(encoder1, 4096);
+ *   angle_position<as5047p_arduino, arduino_platform> angle_pos(sensor);
+ */
+
+#ifndef _POSITION_SOURCE_H
+#define _POSITION_SOURCE_H
+
+#include <stdint.h>
+
+/** position_snapshot::status bits */
+#define POSITION_OK             0x00
+#define POSITION_ABSOLUTE       0x01    ///< count is an angle within one turn (0 .. cpr - 1)
+#define POSITION_ERROR          0x02    ///< Read failed; count is the last good value
+#define POSITION_GLITCH         0x04    ///< Decoder missed edges (illegal transitions) since the last sample
+
+/** Counts per turn of the AS5047P angle (14 bit, AS5047P_ANGLE_BITS) */
+#define POSITION_AS5047P_CPR    16384
+
+/** One position reading, the same for every driver */
+struct position_snapshot{
+    int64_t count;          ///< Raw count (incremental: unwrapped; absolute: within the turn)
+    uint32_t cpr;           ///< Counts per turn (0 if unknown)
+    uint32_t time_us;       ///< When the count was latched (micros())
+    uint8_t status;         ///< POSITION_xxx
+};
+
+/** Position as a fraction of turns (Q16), 0 if cpr is unknown */
+static inline int64_t position_turns_q16(const position_snapshot &snap){
+    return snap.cpr ? (snap.count * 65536) / (int64_t)snap.cpr : 0;
+}
+
+/** Counts moved from a to b (shortest way round for absolute sources) */
+static inline int64_t position_delta(const position_snapshot &a, const position_snapshot &b){
+    int64_t d = b.count - a.count;
+    if ((b.status & POSITION_ABSOLUTE) && b.cpr) {
+        int64_t half = b.cpr / 2;
+        d = ((d + half) % (int64_t)b.cpr + b.cpr) % (int64_t)b.cpr - half;
+    }
+    return d;
+}
+
+/** Static interface; D provides samplePosition() and countsPerTurn() */
+template <class D>
+class position_source{
+    protected:
+        ~position_source() {}
+
+    public:
+        /** Take a snapshot
+         *
+         *  @param snap     Snapshot (count keeps the last good value on failure)
+         *  @return         false if the read failed (snap->status has POSITION_ERROR)
+         */
+        bool sample(position_snapshot *snap){
+            return static_cast<D*>(this)->samplePosition(snap);
+        }
+
+        /** Counts per turn (0 if unknown) */
+        uint32_t getCountsPerTurn(){
+            return static_cast<D*>(this)->countsPerTurn();
+        }
+};
+
+/** Unwraps a 32-bit hardware counter to 64 bit */
+class position_unwrap{
+    private:
+        int64_t count;
+        int32_t last;
+
+    public:
+        position_unwrap() : count(0), last(0) {}
+
+        int64_t update(int32_t raw){
+            count += (int32_t)((uint32_t)raw - (uint32_t)last);
+            last = raw;
+            return count;
+        }
+};
+
+/** Counter with sync() / getCount() / getSyncMicros() (LS7366R_Single) */
+template <class C>
+class counter_position : public position_source<counter_position<C> >{
+    private:
+        C &counter;
+        uint32_t cpr;
+        position_unwrap unwrap;
+
+    public:
+        /** @param cpr  Counts per turn of the encoder (0 if unknown) */
+        explicit counter_position(C &counter, uint32_t cpr = 0) : counter(counter), cpr(cpr) {}
+
+        bool samplePosition(position_snapshot *snap){
+            counter.sync();
+            snap->count = unwrap.update(counter.getCount());
+            snap->cpr = cpr;
+            snap->time_us = counter.getSyncMicros();
+            snap->status = POSITION_OK;
+            return true;
+        }
+
+        uint32_t countsPerTurn() { return cpr; }
+};
+
+/** One side of a two-chip counter with sync() / left() / right() (LS7366R)
+ *
+ *  Each sample syncs both chips; P gives the timestamp.
+ */
+template <class C, class P>
+class counter_pair_position : public position_source<counter_pair_position<C, P> >{
+    private:
+        C &counter;
+        bool right;
+        uint32_t cpr;
+        position_unwrap unwrap;
+
+    public:
+        /** @param right    true for the right-hand chip
+         *  @param cpr      Counts per turn of the encoder (0 if unknown)
+         */
+        counter_pair_position(C &counter, bool right, uint32_t cpr = 0)
+            : counter(counter), right(right), cpr(cpr) {}
+
+        bool samplePosition(position_snapshot *snap){
+            counter.sync();
+            snap->time_us = P::micros();
+            snap->count = unwrap.update((int32_t)(right ? counter.right() : counter.left()));
+            snap->cpr = cpr;
+            snap->status = POSITION_OK;
+            return true;
+        }
+
+        uint32_t countsPerTurn() { return cpr; }
+};
+
+/** Software quadrature decoder (abi_encoder_arduino, abi_encoder_core<P>) */
+template <class E>
+class decoder_position : public position_source<decoder_position<E> >{
+    private:
+        E &encoder;
+        uint32_t illegal;
+
+    public:
+        explicit decoder_position(E &encoder) : encoder(encoder), illegal(encoder.getIllegalTransitions()) {}
+
+        bool samplePosition(position_snapshot *snap){
+            encoder.getEdgeSnapshot(&snap->count, &snap->time_us);
+            snap->cpr = encoder.getSPR();
+            uint32_t now = encoder.getIllegalTransitions();
+            snap->status = now != illegal ? POSITION_GLITCH : POSITION_OK;
+            illegal = now;
+            return true;
+        }
+
+        uint32_t countsPerTurn() { return encoder.getSPR(); }
+};
+
+/** AS5047P absolute angle (as5047p_arduino, as5047p_core<P>); the sensor stamps the angle, P is unused */
+template <class S, class P>
+class angle_position : public position_source<angle_position<S, P> >{
+    private:
+        S &sensor;
+        uint32_t faults;        // Parity errors + error frames seen so far
+        uint16_t last;
+
+    public:
+        explicit angle_position(S &sensor)
+            : sensor(sensor), faults(sensor.getParityErrors() + sensor.getErrorFrames()), last(0) {}
+
+        bool samplePosition(position_snapshot *snap){
+            // One frame per sample: the angle was latched by the previous
+            // sample's frame, and is stamped with that time
+            uint16_t angle;
+            sensor.readAnglePipelined(&angle);
+            snap->time_us = sensor.getAngleMicros();
+            uint32_t now = sensor.getParityErrors() + sensor.getErrorFrames();
+            bool ok = now == faults;
+            faults = now;
+            if (ok) {
+                last = angle;
+            }
+            snap->count = last;
+            snap->cpr = POSITION_AS5047P_CPR;
+            snap->status = POSITION_ABSOLUTE | (ok ? POSITION_OK : POSITION_ERROR);
+            return ok;
+        }
+
+        uint32_t countsPerTurn() { return POSITION_AS5047P_CPR; }
+};
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file platform.h
+ * @brief Common definitions for the GPIO/timing platform policies
+ *
+ * The drivers' portable cores (as5047p_core, abi_encoder_core) are
+ * templates over a platform policy P that provides:
+ *
+ *   P::pin_t                   Pin identifier type
+ *   P::NO_PIN                  Value of pin_t meaning "not connected"
+ *   P::output(pin)             Push-pull output, .write(level)
+ *   P::input(pin, pull)        Input, .read()
+ *   P::micros()                Free-running microsecond timestamp (uint32_t)
+ *   P::delayMicros(us)         Busy wait
+ *   P::delayMillis(ms)         Busy wait
+ *   P::nop()                   One CPU no-op
+ *   P::lock() / P::unlock()    Mask the decoder interrupts (task context)
+ *   P::lockFromISR() / P::unlockFromISR()
+ *                              The same exclusion from inside a decoder
+ *                              interrupt (no-op where an ISR cannot be
+ *                              preempted by another decoder ISR or core)
+ *   P::timer                   Periodic callback, .start(period_us, fn, ctx) / .stop()
+ *
+ * P::timer runs fn(ctx) every period_us from a hardware timer, in a
+ * context where the bus drivers may be called (a high-priority task on
+ * ESP32, the Ticker interrupt on mbed, a virtual-time event on
+ * host_platform, a thread on thread_platform). Ticks that fall while fn
+ * is still running are dropped, not queued. Policies without a hardware
+ * timer do not define it.
+ *
+ * Policies:
+ * - arduino_platform  (platform_arduino.h)
+ * - mbed_platform     (platform_mbed.h)
+ * - host_platform     (platform_host.h, host simulation)
+ * - thread_platform   (platform_thread.h, host threads, time and timer only)
+ */
+
+#ifndef _PLATFORM_H
+#define _PLATFORM_H
+
+/** Periodic callback of P::timer */
+typedef void (*platform_timer_fn)(void *ctx);
+
+/** Input pull configuration */
+enum platform_pull{
+    PLATFORM_PULL_NONE = 0,
+    PLATFORM_PULL_UP,
+    PLATFORM_PULL_DOWN
+};
+
+#endif
@@ -0,0 +1,175 @@
+/**
+ * @file platform_arduino.h
+ * @brief Arduino platform policy for the portable driver cores
+ */
+
+#ifndef _PLATFORM_ARDUINO_H
+#define _PLATFORM_ARDUINO_H
+
+#include <Arduino.h>
+#include "platform.h"
+
+#if defined(ESP32)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/** Core and priority of the task that runs P::timer callbacks */
+#ifndef PLATFORM_TIMER_CORE
+#define PLATFORM_TIMER_CORE         1       // Same core as loop()
+#endif
+#ifndef PLATFORM_TIMER_PRIORITY
+#define PLATFORM_TIMER_PRIORITY     (configMAX_PRIORITIES - 1)
+#endif
+#define PLATFORM_TIMER_STACK        4096
+#endif
+
+struct arduino_platform{
+    typedef uint8_t pin_t;
+    static const pin_t NO_PIN = 0xFF;
+
+    class output{
+        private:
+            pin_t pin;
+        public:
+            explicit output(pin_t pin) : pin(pin) {
+                if (pin != NO_PIN) {
+                    pinMode(pin, OUTPUT);
+                }
+            }
+            void write(int level) { digitalWrite(pin, level ? HIGH : LOW); }
+    };
+
+    class input{
+        private:
+            pin_t pin;
+        public:
+            input(pin_t pin, platform_pull pull) : pin(pin) {
+                if (pull == PLATFORM_PULL_UP) {
+                    pinMode(pin, INPUT_PULLUP);
+#if defined(INPUT_PULLDOWN)
+                } else if (pull == PLATFORM_PULL_DOWN) {
+                    pinMode(pin, INPUT_PULLDOWN);
+#endif
+                } else {
+                    pinMode(pin, INPUT);
+                }
+            }
+            int read() { return digitalRead(pin) ? 1 : 0; }
+    };
+
+    static uint32_t micros() { return ::micros(); }
+    static void delayMicros(uint32_t us) { ::delayMicroseconds(us); }
+    static void delayMillis(uint32_t ms) { ::delay(ms); }
+
+    static void nop(){
+#if defined(__AVR__) || defined(ESP32) || defined(ESP8266)
+        asm volatile("nop");
+#else
+        __asm__ __volatile__("nop");
+#endif
+    }
+
+#if defined(ESP32)
+    // noInterrupts() does not mask anything on the ESP32 core, and the
+    // decoder ISRs may run on the other core: a spinlock critical section
+    // covers both (and nests on the same core)
+    static portMUX_TYPE *mux(){
+        static portMUX_TYPE m = portMUX_INITIALIZER_UNLOCKED;
+        return &m;
+    }
+    static void lock() { portENTER_CRITICAL(mux()); }
+    static void unlock() { portEXIT_CRITICAL(mux()); }
+    static void lockFromISR() { portENTER_CRITICAL_ISR(mux()); }
+    static void unlockFromISR() { portEXIT_CRITICAL_ISR(mux()); }
+#else
+    // Single core: masking interrupts is enough, and an ISR already runs masked
+    static void lock() { noInterrupts(); }
+    static void unlock() { interrupts(); }
+    static void lockFromISR() {}
+    static void unlockFromISR() {}
+#endif
+
+#if defined(ESP32)
+    // The SPI driver takes a mutex, so the timer interrupt only wakes a
+    // high-priority task that calls fn. Wakes that arrive while fn runs
+    // collapse into one (ulTaskNotifyTake clears the count).
+    class timer{
+        private:
+            hw_timer_t *hw;
+            TaskHandle_t task;
+            platform_timer_fn fn;
+            void *ctx;
+
+#if ESP_ARDUINO_VERSION_MAJOR < 3
+            static timer *&instance() {
+                static timer *t = 0;
+                return t;
+            }
+            static void IRAM_ATTR isr() { wake(instance()); }
+#else
+            static void IRAM_ATTR isr(void *arg) { wake((timer*)arg); }
+#endif
+
+            static void IRAM_ATTR wake(timer *t){
+                BaseType_t woken = pdFALSE;
+                if (t && t->task) {
+                    vTaskNotifyGiveFromISR(t->task, &woken);
+                }
+                if (woken) {
+                    portYIELD_FROM_ISR();
+                }
+            }
+
+            static void run(void *arg){
+                timer *t = (timer*)arg;
+                for (;;) {
+                    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                    t->fn(t->ctx);
+                }
+            }
+
+        public:
+            timer() : hw(0), task(0), fn(0), ctx(0) {}
+            ~timer() { stop(); }
+
+            bool start(uint32_t period_us, platform_timer_fn fn, void *ctx){
+                if (hw || !period_us) {
+                    return false;
+                }
+                this->fn = fn;
+                this->ctx = ctx;
+                if (xTaskCreatePinnedToCore(run, "ptimer", PLATFORM_TIMER_STACK, this,
+                                            PLATFORM_TIMER_PRIORITY, &task, PLATFORM_TIMER_CORE) != pdPASS) {
+                    task = 0;
+                    return false;
+                }
+#if ESP_ARDUINO_VERSION_MAJOR < 3
+                // 80 MHz APB / 80 = 1 MHz; one timer per program on the 2.x API
+                instance() = this;
+                hw = timerBegin(0, 80, true);
+                timerAttachInterrupt(hw, isr, true);
+                timerAlarmWrite(hw, period_us, true);
+                timerAlarmEnable(hw);
+#else
+                hw = timerBegin(1000000);
+                timerAttachInterruptArg(hw, isr, this);
+                timerAlarm(hw, period_us, true, 0);
+#endif
+                return true;
+            }
+
+            void stop(){
+                if (hw) {
+                    timerEnd(hw);
+                    hw = 0;
+                }
+                if (task) {
+                    vTaskDelete(task);
+                    task = 0;
+                }
+            }
+    };
+#endif
+};
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file platform_host.h
+ * @brief Host simulation platform policy for the portable driver cores
+ *
+ * Pins and time come from host_sim: pin writes notify the simulated
+ * devices attached to them, and delays advance virtual time instead of
+ * sleeping, so a driver call costs its real CPU time on the host plus
+ * its bus time in host_sim::nanos().
+ */
+
+#ifndef _PLATFORM_HOST_H
+#define _PLATFORM_HOST_H
+
+#include <stdint.h>
+#include "platform.h"
+#include "host_sim.h"
+
+struct host_platform{
+    typedef int pin_t;
+    static const pin_t NO_PIN = -1;
+
+    class output{
+        private:
+            pin_t pin;
+        public:
+            explicit output(pin_t pin) : pin(pin) {}
+            void write(int level) { host_sim::write(pin, level); }
+    };
+
+    class input{
+        private:
+            pin_t pin;
+        public:
+            input(pin_t pin, platform_pull pull) : pin(pin) {
+                if (pull == PLATFORM_PULL_UP) {
+                    host_sim::pull(pin, 1);
+                } else if (pull == PLATFORM_PULL_DOWN) {
+                    host_sim::pull(pin, 0);
+                }
+            }
+            int read() { return host_sim::read(pin); }
+    };
+
+    static uint32_t micros() { return host_sim::micros(); }
+    static void delayMicros(uint32_t us) { host_sim::advance((uint64_t)us * 1000); }
+    static void delayMillis(uint32_t ms) { host_sim::advance((uint64_t)ms * 1000000); }
+    static void nop() {}
+
+    static void lock() {}
+    static void unlock() {}
+    static void lockFromISR() {}
+    static void unlockFromISR() {}
+
+    // Virtual-time event on a fixed grid; slots passed while fn runs are skipped
+    class timer{
+        private:
+            uint64_t next_ns;
+            uint64_t period_ns;
+            platform_timer_fn fn;
+            void *ctx;
+
+            static void fire(void *arg){
+                timer *t = (timer*)arg;
+                t->fn(t->ctx);
+                uint64_t now = host_sim::nanos();
+                do {
+                    t->next_ns += t->period_ns;
+                } while (t->next_ns <= now);
+                host_sim::schedule(t->next_ns, fire, t);
+            }
+
+        public:
+            timer() : next_ns(0), period_ns(0), fn(0), ctx(0) {}
+            ~timer() { stop(); }
+
+            bool start(uint32_t period_us, platform_timer_fn fn, void *ctx){
+                if (!period_us) {
+                    return false;
+                }
+                stop();
+                this->fn = fn;
+                this->ctx = ctx;
+                period_ns = (uint64_t)period_us * 1000;
+                next_ns = host_sim::nanos() + period_ns;
+                return host_sim::schedule(next_ns, fire, this);
+            }
+
+            void stop() { host_sim::cancel(fire, this); }
+    };
+};
+
+#endif
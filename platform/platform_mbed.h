@@ -0,0 +1,72 @@
+/**
+ * @file platform_mbed.h
+ * @brief mbed platform policy for the portable driver cores
+ */
+
+#ifndef _PLATFORM_MBED_H
+#define _PLATFORM_MBED_H
+
+#include "mbed.h"
+#include "platform.h"
+
+struct mbed_platform{
+    typedef PinName pin_t;
+    static const pin_t NO_PIN = NC;
+
+    class output{
+        private:
+            DigitalOut io;
+        public:
+            explicit output(pin_t pin) : io(pin) {}
+            void write(int level) { io.write(level); }
+    };
+
+    class input{
+        private:
+            DigitalIn io;
+        public:
+            input(pin_t pin, platform_pull pull) : io(pin) {
+                io.mode(pull == PLATFORM_PULL_UP ? PullUp :
+                        pull == PLATFORM_PULL_DOWN ? PullDown : PullNone);
+            }
+            int read() { return io.read(); }
+    };
+
+    static uint32_t micros() { return us_ticker_read(); }
+    static void delayMicros(uint32_t us) { wait_us(us); }
+    static void delayMillis(uint32_t ms) { wait_us(ms * 1000); }
+    static void nop() { __NOP(); }
+
+    static void lock() { core_util_critical_section_enter(); }
+    static void unlock() { core_util_critical_section_exit(); }
+    static void lockFromISR() {}
+    static void unlockFromISR() {}
+
+    // Ticker callbacks run in interrupt context; the bit-bang drivers are safe there
+    class timer{
+        private:
+            Ticker ticker;
+            platform_timer_fn fn;
+            void *ctx;
+
+            void fire() { fn(ctx); }
+
+        public:
+            timer() : fn(0), ctx(0) {}
+            ~timer() { stop(); }
+
+            bool start(uint32_t period_us, platform_timer_fn fn, void *ctx){
+                if (!period_us) {
+                    return false;
+                }
+                this->fn = fn;
+                this->ctx = ctx;
+                ticker.attach_us(callback(this, &timer::fire), period_us);
+                return true;
+            }
+
+            void stop() { ticker.detach(); }
+    };
+};
+
+#endif
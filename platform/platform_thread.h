@@ -0,0 +1,112 @@
+/**
+ * @file platform_thread.h
+ * @brief Host platform policy on real time and std::thread
+ *
+ * Host only. Stands in for the ESP32 dual-core setup when measuring the
+ * sampling pipeline on a PC: P::timer callbacks run on their own thread,
+ * optionally pinned to one CPU (PLATFORM_TIMER_CORE, as the ESP32 task),
+ * while the consumer runs on the calling thread. Time is std::chrono's
+ * steady clock.
+ *
+ * There are no pins: use it for code that only needs time and the timer
+ * (encoder_sampler with function sources). Drivers go on host_platform.
+ *
+ * Link with -pthread.
+ */
+
+#ifndef _PLATFORM_THREAD_H
+#define _PLATFORM_THREAD_H
+
+#include <stdint.h>
+#include <chrono>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include "platform.h"
+
+/** CPU of the timer thread (-1 = not pinned) */
+#ifndef PLATFORM_TIMER_CORE
+#define PLATFORM_TIMER_CORE     -1
+#endif
+
+struct thread_platform{
+    typedef std::chrono::steady_clock clock;
+
+    static uint32_t micros(){
+        return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            clock::now().time_since_epoch()).count();
+    }
+    static void delayMicros(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+    static void delayMillis(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+    static void nop() {}
+
+    // No decoder interrupts to mask
+    static void lock() {}
+    static void unlock() {}
+    static void lockFromISR() {}
+    static void unlockFromISR() {}
+
+    /** Pin the calling thread to one CPU
+     *
+     *  @param core     CPU number, -1 to leave it unpinned
+     *  @return         false if the OS refused
+     */
+    static bool pinToCore(int core){
+        if (core < 0) {
+            return true;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+    // Thread on a fixed steady-clock grid; slots passed while fn runs are skipped
+    class timer{
+        private:
+            std::thread worker;
+            bool running;
+            platform_timer_fn fn;
+            void *ctx;
+            clock::duration period;
+
+            static void run(timer *t){
+                pinToCore(PLATFORM_TIMER_CORE);
+                clock::time_point next = clock::now() + t->period;
+                while (__atomic_load_n(&t->running, __ATOMIC_ACQUIRE)) {
+                    std::this_thread::sleep_until(next);
+                    t->fn(t->ctx);
+                    clock::time_point now = clock::now();
+                    do {
+                        next += t->period;
+                    } while (next <= now);
+                }
+            }
+
+        public:
+            timer() : running(false), fn(0), ctx(0), period(0) {}
+            ~timer() { stop(); }
+
+            bool start(uint32_t period_us, platform_timer_fn fn, void *ctx){
+                if (!period_us) {
+                    return false;
+                }
+                stop();
+                this->fn = fn;
+                this->ctx = ctx;
+                period = std::chrono::microseconds(period_us);
+                running = true;
+                worker = std::thread(run, this);
+                return true;
+            }
+
+            void stop(){
+                __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+                if (worker.joinable()) {
+                    worker.join();
+                }
+            }
+    };
+};
+
+#endif
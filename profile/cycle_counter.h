@@ -0,0 +1,78 @@
+/**
+ * @file cycle_counter.h
+ * @brief Free-running CPU cycle counter for short interval measurement
+ *
+ * One backend per target, picked at compile time:
+ *
+ * - ESP32 (Xtensa): the CCOUNT special register
+ * - ARM Cortex-M3/M4/M7/M33: DWT->CYCCNT (enabled by cycle_counter_begin())
+ * - anything else (host): std::chrono::steady_clock in ns
+ *
+ * The counter is 32 bit and wraps (18 s at 240 MHz), so only differences
+ * of two reads are meaningful. cycle_counter_hz() converts to time.
+ */
+
+#ifndef _CYCLE_COUNTER_H
+#define _CYCLE_COUNTER_H
+
+#include <stdint.h>
+
+#if defined(ESP32) && defined(__XTENSA__)
+#define CYCLE_COUNTER_CCOUNT
+#include <Arduino.h>
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+#define CYCLE_COUNTER_DWT
+#else
+#define CYCLE_COUNTER_HOST
+#include <chrono>
+#endif
+
+#ifdef CYCLE_COUNTER_DWT
+// Cortex-M debug registers (ARMv7-M Architecture Reference Manual, C1)
+#define CYCLE_COUNTER_DEMCR         (*(volatile uint32_t*)0xE000EDFC)
+#define CYCLE_COUNTER_DEMCR_TRCENA  0x01000000
+#define CYCLE_COUNTER_DWT_CTRL      (*(volatile uint32_t*)0xE0001000)
+#define CYCLE_COUNTER_DWT_CYCCNTENA 0x00000001
+#define CYCLE_COUNTER_DWT_CYCCNT    (*(volatile uint32_t*)0xE0001004)
+#define CYCLE_COUNTER_DWT_LAR       (*(volatile uint32_t*)0xE0001FB0)
+#define CYCLE_COUNTER_DWT_UNLOCK    0xC5ACCE55
+
+extern "C" uint32_t SystemCoreClock;    // CMSIS
+#endif
+
+/** Start the counter (DWT is off after reset; the others always run) */
+static inline void cycle_counter_begin(){
+#ifdef CYCLE_COUNTER_DWT
+    CYCLE_COUNTER_DEMCR |= CYCLE_COUNTER_DEMCR_TRCENA;
+    CYCLE_COUNTER_DWT_LAR = CYCLE_COUNTER_DWT_UNLOCK;   // Cortex-M7 locks the DWT
+    CYCLE_COUNTER_DWT_CYCCNT = 0;
+    CYCLE_COUNTER_DWT_CTRL |= CYCLE_COUNTER_DWT_CYCCNTENA;
+#endif
+}
+
+/** Current count */
+static inline uint32_t cycle_counter_now(){
+#if defined(CYCLE_COUNTER_CCOUNT)
+    uint32_t ccount;
+    __asm__ __volatile__("rsr %0, ccount" : "=a"(ccount));
+    return ccount;
+#elif defined(CYCLE_COUNTER_DWT)
+    return CYCLE_COUNTER_DWT_CYCCNT;
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/** Counts per second */
+static inline uint32_t cycle_counter_hz(){
+#if defined(CYCLE_COUNTER_CCOUNT)
+    return getCpuFrequencyMhz() * 1000000UL;
+#elif defined(CYCLE_COUNTER_DWT)
+    return SystemCoreClock;
+#else
+    return 1000000000UL;
+#endif
+}
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * @file op_profile.cpp
+ * @brief Implementation of the per-operation cycle statistics
+ */
+
+#include "op_profile.h"
+
+#define OP_PROFILE_CALIBRATE    64  // Back-to-back counter reads, the fastest is the overhead
+
+op_profile_stats op_profile_table[OP_PROFILE_OPS];
+uint32_t op_profile_overhead = 0;
+
+static const char *const names[OP_PROFILE_OPS] = {
+    "LS7366R sync",
+    "LS7366R readRegister",
+    "LS7366R writeRegister",
+    "AS5047P readAngle",
+    "AS5047P readAnglePipelined",
+    "AS5047P readRegister",
+    "AS5047P writeRegister",
+    "ABI edge",
+    "ABI index"
+};
+
+void op_profile_begin(){
+    cycle_counter_begin();
+
+    uint32_t fastest = 0xFFFFFFFF;
+    for (uint8_t i = 0; i < OP_PROFILE_CALIBRATE; i++) {
+        uint32_t start = cycle_counter_now();
+        uint32_t cycles = cycle_counter_now() - start;
+        if (cycles < fastest) {
+            fastest = cycles;
+        }
+    }
+    op_profile_overhead = fastest;
+    op_profile_reset();
+}
+
+void op_profile_reset(){
+    for (uint8_t op = 0; op < OP_PROFILE_OPS; op++) {
+        op_profile_stats *s = &op_profile_table[op];
+        s->count = 0;
+        s->min = 0;
+        s->max = 0;
+        s->total = 0;
+        for (uint8_t b = 0; b < OP_PROFILE_BUCKETS; b++) {
+            s->buckets[b] = 0;
+        }
+    }
+}
+
+bool op_profile_read(uint8_t op, op_profile_stats *out){
+    if (op >= OP_PROFILE_OPS) {
+        return false;
+    }
+    *out = op_profile_table[op];
+    return true;
+}
+
+const char *op_profile_name(uint8_t op){
+    return op < OP_PROFILE_OPS ? names[op] : "?";
+}
+
+uint32_t op_profile_mean(const op_profile_stats *stats){
+    return stats->count ? (uint32_t)(stats->total / stats->count) : 0;
+}
+
+uint32_t op_profile_percentile(const op_profile_stats *stats, uint16_t per_mille){
+    uint64_t wanted = ((uint64_t)stats->count * per_mille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint8_t b = 0; b < OP_PROFILE_BUCKETS; b++) {
+        seen += stats->buckets[b];
+        if (seen >= wanted && seen) {
+            // The last bucket is open-ended: max is the only bound
+            uint32_t bound = b == OP_PROFILE_BUCKETS - 1 ? stats->max : (2UL << b) - 1;
+            return bound < stats->max ? bound : stats->max;
+        }
+    }
+    return stats->max;
+}
+
+uint32_t op_profile_ns(uint32_t cycles){
+    return (uint32_t)((uint64_t)cycles * 1000000000ULL / cycle_counter_hz());
+}
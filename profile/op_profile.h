@@ -0,0 +1,137 @@
+/**
+ * @file op_profile.h
+ * @brief Per-operation cycle statistics for the driver hot paths
+ *
+ * Built with -DOP_PROFILE, the drivers time their hot calls with the
+ * cycle counter (cycle_counter.h) and fold each call into the statistics
+ * of its operation: count, min, max, total (mean) and a log2 histogram.
+ * Without OP_PROFILE the drivers contain no profiling code at all, so the
+ * hooks can stay in production sources.
+ *
+ *   LS7366R_Single   sync(), register reads / writes
+ *   as5047p_core     readAngleRaw() (so every readAngle*()), the
+ *                    pipelined angle read, register reads, blocking
+ *                    register writes
+ *   abi_encoder_core edge() and indexEdge(), i.e. the A/B/Z interrupts
+ *
+ * Times are inclusive: an AS5047P angle read through MOSI also counts as
+ * a register read. The cost of reading the counter itself is measured by
+ * op_profile_begin() and subtracted.
+ *
+ *   op_profile_begin();
+ *   ...
+ *   op_profile_stats s;
+ *   op_profile_read(OP_PROFILE_LS7366R_SYNC, &s);
+ *   op_profile_ns(op_profile_mean(&s));
+ *
+ * Each operation should be recorded from one context at a time (one task,
+ * or one interrupt); the update is not atomic, and a read that races an
+ * update may be off by that one call.
+ */
+
+#ifndef _OP_PROFILE_H
+#define _OP_PROFILE_H
+
+#include <stdint.h>
+#include "cycle_counter.h"
+
+/** Histogram buckets: bucket b counts calls of 2^b .. 2^(b+1)-1 cycles */
+#define OP_PROFILE_BUCKETS      24
+
+/** Profiled operations */
+enum op_profile_op{
+    OP_PROFILE_LS7366R_SYNC = 0,
+    OP_PROFILE_LS7366R_READ_REGISTER,
+    OP_PROFILE_LS7366R_WRITE_REGISTER,
+    OP_PROFILE_AS5047P_READ_ANGLE,
+    OP_PROFILE_AS5047P_READ_ANGLE_PIPELINED,
+    OP_PROFILE_AS5047P_READ_REGISTER,
+    OP_PROFILE_AS5047P_WRITE_REGISTER,
+    OP_PROFILE_ABI_EDGE,
+    OP_PROFILE_ABI_INDEX,
+    OP_PROFILE_OPS
+};
+
+/** Statistics of one operation (cycles of cycle_counter_now()) */
+struct op_profile_stats{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t buckets[OP_PROFILE_BUCKETS];
+};
+
+extern op_profile_stats op_profile_table[OP_PROFILE_OPS];
+extern uint32_t op_profile_overhead;
+
+/** Start the counter, measure its own cost and clear the statistics */
+void op_profile_begin();
+
+/** Clear the statistics */
+void op_profile_reset();
+
+/** Copy the statistics of an operation
+ *
+ *  @param op   Operation (OP_PROFILE_xxx)
+ *  @param out  Statistics
+ *  @return     false if op is out of range
+ */
+bool op_profile_read(uint8_t op, op_profile_stats *out);
+
+/** Name of an operation, e.g. "LS7366R sync" */
+const char *op_profile_name(uint8_t op);
+
+/** Mean cycles per call, 0 before the first call */
+uint32_t op_profile_mean(const op_profile_stats *stats);
+
+/** Upper bound of the histogram bucket holding a percentile
+ *
+ *  @param per_mille    Percentile (990: 99th)
+ *  @return             Cycles that per_mille of the calls stayed below
+ */
+uint32_t op_profile_percentile(const op_profile_stats *stats, uint16_t per_mille);
+
+/** Cycles to ns */
+uint32_t op_profile_ns(uint32_t cycles);
+
+/** Histogram bucket of a call */
+static inline uint8_t op_profile_bucket(uint32_t cycles){
+    uint8_t bucket = cycles ? (uint8_t)(31 - __builtin_clz(cycles)) : 0;
+    return bucket < OP_PROFILE_BUCKETS ? bucket : OP_PROFILE_BUCKETS - 1;
+}
+
+/** Add one call to an operation */
+static inline void op_profile_record(uint8_t op, uint32_t cycles){
+    op_profile_stats *s = &op_profile_table[op];
+    cycles = cycles > op_profile_overhead ? cycles - op_profile_overhead : 0;
+    if (s->count++ == 0 || cycles < s->min) {
+        s->min = cycles;
+    }
+    if (cycles > s->max) {
+        s->max = cycles;
+    }
+    s->total += cycles;
+    s->buckets[op_profile_bucket(cycles)]++;
+}
+
+/** Times its own lifetime as one call of an operation
+ *
+ *  {
+ *      op_profile_scope profile(OP_PROFILE_LS7366R_SYNC);
+ *      ...
+ *  }
+ */
+class op_profile_scope{
+    private:
+        uint32_t start;
+        uint8_t op;
+
+    public:
+        explicit op_profile_scope(uint8_t op) : start(cycle_counter_now()), op(op) {
+        }
+        ~op_profile_scope(){
+            op_profile_record(op, cycle_counter_now() - start);
+        }
+};
+
+#endif
@@ -0,0 +1,288 @@
+/**
+ * @file encoder_sampler.h
+ * @brief Fixed-rate encoder sampling from a hardware timer
+ *
+ * Reads a configured set of devices (LS7366R_Single counts, AS5047P
+ * angles, or any int32_t source) on every tick of the platform timer
+ * P::timer and publishes timestamped snapshots:
+ *
+ * - read():       every snapshot in order, from a lock-free ring
+ * - readLatest(): only the newest one
+ *
+ * Neither blocks the timer or the consumer. The sampler also measures
+ * the tick period it actually got (min / max / jitter against the
+ * nominal period), ticks it missed, ticks whose reads took longer than
+ * one period (overruns) and snapshots the consumer did not drain in time.
+ *
+ *   encoder_sampler<arduino_platform> sampler;
+ *   sampler.addCounter(encoder1);             // LS7366R_Single
+ *   sampler.addAngle(sensor);                 // as5047p_arduino
+ *   sampler.addPosition(decoder_pos);         // any position_source
+ *   sampler.begin(1000);                      // 1 kHz
+ *   ...
+ *   encoder_snapshot snap;
+ *   while (sampler.read(&snap)) { ... }
+ */
+
+#ifndef _ENCODER_SAMPLER_H
+#define _ENCODER_SAMPLER_H
+
+#include <stdint.h>
+#include "platform.h"
+#include "snapshot_ring.h"
+#include "position_source.h"
+
+/** Sources per snapshot */
+#define ENCODER_SAMPLER_SOURCES     4
+
+/** Snapshots buffered for read() (power of two) */
+#define ENCODER_SAMPLER_BUFFER      64
+
+/** Reads one value; called from the timer context */
+typedef int32_t (*encoder_sampler_source)(void *ctx);
+
+/** One tick's readings */
+struct encoder_snapshot{
+    uint32_t seq;                                   ///< Tick number since begin()
+    uint32_t time_us;                               ///< Start of the tick
+    uint16_t read_us;                               ///< Time spent reading the sources
+    uint8_t count;                                  ///< Values used
+    int32_t value[ENCODER_SAMPLER_SOURCES];         ///< In addSource() order
+};
+
+/** Timing statistics since begin() or resetStats() */
+struct encoder_sampler_stats{
+    uint32_t samples;           ///< Ticks run
+    uint32_t missed;            ///< Ticks that never ran (late by a whole period)
+    uint32_t overruns;          ///< Ticks whose reads took longer than the period
+    uint32_t dropped;           ///< Snapshots lost because the ring was full
+    uint32_t period_min_us;     ///< Shortest tick-to-tick time
+    uint32_t period_max_us;     ///< Longest tick-to-tick time
+    uint32_t jitter_max_us;     ///< Largest |period - nominal|
+    uint32_t jitter_mean_us;    ///< Mean |period - nominal|
+};
+
+template <class P>
+class encoder_sampler{
+    private:
+        typename P::timer timer;
+
+        encoder_sampler_source sources[ENCODER_SAMPLER_SOURCES];
+        void *contexts[ENCODER_SAMPLER_SOURCES];
+        uint8_t count;
+
+        snapshot_ring<encoder_snapshot, ENCODER_SAMPLER_BUFFER> ring;
+        snapshot_latest<encoder_snapshot> latest;
+
+        uint32_t period_us;
+        uint32_t seq;
+        uint32_t last_us;
+
+        // Written by the timer only; copied out by getStats()
+        volatile uint32_t samples;
+        volatile uint32_t missed;
+        volatile uint32_t overruns;
+        volatile uint32_t period_min;
+        volatile uint32_t period_max;
+        volatile uint32_t jitter_max;
+        volatile uint64_t jitter_sum;
+        volatile uint32_t dropped_base;
+
+        template <class C>
+        static int32_t readCounter(void *ctx){
+            C *counter = (C*)ctx;
+            counter->sync();
+            return counter->getCount();
+        }
+
+        template <class S>
+        static int32_t readAngle(void *ctx){
+            // Priming + read: latched within this tick, next to the counts,
+            // without the settle delay of readAngleRaw()
+            S *sensor = (S*)ctx;
+            uint16_t raw;
+            sensor->restartAngle();
+            sensor->readAngleRawPipelined(&raw);
+            return raw;
+        }
+
+        template <class S>
+        static int32_t readPosition(void *ctx){
+            position_snapshot snap;
+            static_cast<position_source<S>*>(ctx)->sample(&snap);
+            return (int32_t)snap.count;
+        }
+
+        static void onTick(void *ctx){
+            ((encoder_sampler*)ctx)->tick();
+        }
+
+    public:
+        encoder_sampler() : count(0), period_us(0), seq(0), last_us(0) {
+            resetStats();
+        }
+
+        ~encoder_sampler() { end(); }
+
+        /** Add a value source
+         *
+         *  @param fn   Reads the value (timer context)
+         *  @param ctx  Passed back to fn
+         *  @return     Index in encoder_snapshot::value, -1 if full
+         */
+        int addSource(encoder_sampler_source fn, void *ctx){
+            if (count >= ENCODER_SAMPLER_SOURCES) {
+                return -1;
+            }
+            sources[count] = fn;
+            contexts[count] = ctx;
+            return count++;
+        }
+
+        /** Add a counter read with sync() / getCount() (LS7366R_Single) */
+        template <class C>
+        int addCounter(C &counter){
+            return addSource(readCounter<C>, &counter);
+        }
+
+        /** Add a raw angle latched within each tick (as5047p_arduino) */
+        template <class S>
+        int addAngle(S &sensor){
+            return addSource(readAngle<S>, &sensor);
+        }
+
+        /** Add any position_source (low 32 bits of the count) */
+        template <class S>
+        int addPosition(position_source<S> &source){
+            return addSource(readPosition<S>, &source);
+        }
+
+        /** Start sampling
+         *
+         *  @param rate_hz  Sample rate (1 .. 1000000)
+         *  @return         false if the timer could not be started
+         */
+        bool begin(uint32_t rate_hz){
+            end();
+            if (!setRate(rate_hz)) {
+                return false;
+            }
+            return timer.start(period_us, onTick, this);
+        }
+
+        /** Set the rate without starting the timer
+         *
+         *  For sampling driven by someone else calling tick() at that rate
+         *  (e.g. a poll_scheduler operation); restarts the statistics.
+         *
+         *  @param rate_hz  Sample rate (1 .. 1000000)
+         *  @return         false if out of range
+         */
+        bool setRate(uint32_t rate_hz){
+            if (!rate_hz || rate_hz > 1000000) {
+                return false;
+            }
+            period_us = 1000000 / rate_hz;
+            seq = 0;
+            resetStats();
+            return true;
+        }
+
+        /** Stop sampling (buffered snapshots stay readable) */
+        void end(){
+            timer.stop();
+        }
+
+        /** Take one tick (called by the timer, or by the caller after setRate()) */
+        void tick(){
+            uint32_t now = P::micros();
+
+            if (samples) {
+                uint32_t period = now - last_us;
+                uint32_t jitter = period > period_us ? period - period_us : period_us - period;
+                if (period < period_min) period_min = period;
+                if (period > period_max) period_max = period;
+                if (jitter > jitter_max) jitter_max = jitter;
+                jitter_sum = jitter_sum + jitter;
+                if (period >= 2 * period_us) {
+                    missed = missed + (period + period_us / 2) / period_us - 1;
+                }
+            }
+            last_us = now;
+
+            encoder_snapshot snap;
+            snap.seq = seq++;
+            snap.time_us = now;
+            snap.count = count;
+            for (uint8_t i = 0; i < count; i++) {
+                snap.value[i] = sources[i](contexts[i]);
+            }
+            uint32_t took = P::micros() - now;
+            snap.read_us = took > 0xFFFF ? 0xFFFF : (uint16_t)took;
+            if (took > period_us) {
+                overruns = overruns + 1;
+            }
+
+            ring.push(snap);
+            latest.write(snap);
+            samples = samples + 1;
+        }
+
+        /** Take the oldest snapshot
+         *
+         *  @param snap     Snapshot
+         *  @return         false if none is waiting
+         */
+        bool read(encoder_snapshot *snap){
+            return ring.pop(snap);
+        }
+
+        /** Copy the newest snapshot (does not consume read() data)
+         *
+         *  @param snap     Snapshot
+         *  @return         false before the first tick
+         */
+        bool readLatest(encoder_snapshot *snap){
+            return latest.read(snap);
+        }
+
+        /** Get the nominal period
+         *
+         *  @return     Period (us), 0 before begin()
+         */
+        uint32_t getPeriodMicros(){
+            return period_us;
+        }
+
+        /** Get the timing statistics
+         *
+         *  Values may straddle one tick if the timer runs meanwhile.
+         *
+         *  @param stats    Statistics
+         */
+        void getStats(encoder_sampler_stats *stats){
+            uint32_t n = samples;
+            stats->samples = n;
+            stats->missed = missed;
+            stats->overruns = overruns;
+            stats->dropped = ring.getDropped() - dropped_base;
+            stats->period_min_us = n > 1 ? period_min : 0;
+            stats->period_max_us = period_max;
+            stats->jitter_max_us = jitter_max;
+            stats->jitter_mean_us = n > 1 ? (uint32_t)(jitter_sum / (n - 1)) : 0;
+        }
+
+        /** Restart the timing statistics */
+        void resetStats(){
+            samples = 0;
+            missed = 0;
+            overruns = 0;
+            period_min = 0xFFFFFFFF;
+            period_max = 0;
+            jitter_max = 0;
+            jitter_sum = 0;
+            dropped_base = ring.getDropped();
+        }
+};
+
+#endif
@@ -0,0 +1,381 @@
+/**
+ * @file poll_scheduler.h
+ * @brief Rate-monotonic static cyclic scheduler for device polling
+ *
+ * Each operation (an LS7366R count read, an AS5047P cross-check, a status
+ * read...) registers its own period. begin() builds a static cyclic
+ * schedule and runs it from the platform timer P::timer:
+ *
+ * - minor cycle (slot) = greatest common divisor of the periods
+ * - major cycle = least common multiple, as a table of slots
+ * - operations are placed shortest period first (rate-monotonic); each
+ *   gets the phase whose slots carry the least load so far, so slower
+ *   operations fill the gaps between the faster ones instead of piling
+ *   up in slot 0
+ * - within a slot operations run shortest period first
+ *
+ * Each operation has a time budget (given, or measured by running it a
+ * few times at begin()). The schedule is planned with the budgets, then
+ * measured while it runs: per-slot worst time against the plan, and per
+ * operation the runs, the worst time, the runs over budget (overruns) and
+ * the runs lost because the timer missed their slot.
+ *
+ *   poll_scheduler<arduino_platform> scheduler;
+ *   scheduler.addOperation(readCounts, 0, 100);          // 10 kHz
+ *   scheduler.addOperation(crossCheck, 0, 1000);         // 1 kHz
+ *   scheduler.addOperation(readStatus, 0, 100000);       // 10 Hz
+ *   if (scheduler.begin() != POLL_SCHEDULER_OK) { ... }
+ */
+
+#ifndef _POLL_SCHEDULER_H
+#define _POLL_SCHEDULER_H
+
+#include <stdint.h>
+#include "platform.h"
+
+/** Operations */
+#define POLL_SCHEDULER_OPS      8
+
+/** Slots in the major cycle (longest period / shortest common step) */
+#define POLL_SCHEDULER_SLOTS    1000
+
+/** Runs used to measure an operation registered without a budget */
+#define POLL_SCHEDULER_PROBES   3
+
+/** One polling operation; called from the timer context */
+typedef void (*poll_operation)(void *ctx);
+
+/** Result of begin() / build() */
+enum poll_scheduler_status{
+    POLL_SCHEDULER_OK = 0,
+    POLL_SCHEDULER_OVERLOADED,      ///< Runs, but a slot's budgets exceed the slot
+    POLL_SCHEDULER_NO_OPS,          ///< Nothing registered
+    POLL_SCHEDULER_TOO_MANY_SLOTS,  ///< Major cycle longer than POLL_SCHEDULER_SLOTS slots
+    POLL_SCHEDULER_TIMER_FAILED     ///< P::timer did not start
+};
+
+/** Per-operation statistics since begin() or resetStats() */
+struct poll_operation_stats{
+    uint32_t period_us;
+    uint16_t budget_us;
+    uint16_t phase;             ///< First slot of the operation in the major cycle
+    uint32_t runs;
+    uint32_t overruns;          ///< Runs that took longer than the budget
+    uint32_t missed;            ///< Runs lost to missed timer ticks
+    uint16_t max_us;            ///< Worst run time
+};
+
+template <class P>
+class poll_scheduler{
+    private:
+        struct operation{
+            poll_operation fn;
+            void *ctx;
+            uint32_t period_us;
+            uint16_t budget_us;
+            uint16_t period_slots;
+            uint16_t phase;
+            volatile uint32_t runs;
+            volatile uint32_t overruns;
+            volatile uint32_t missed;
+            volatile uint16_t max_us;
+        };
+
+        typename P::timer timer;
+
+        operation ops[POLL_SCHEDULER_OPS];
+        uint8_t order[POLL_SCHEDULER_OPS];      // Shortest period first
+        uint8_t count;
+
+        uint32_t base_us;                       // Slot length
+        uint16_t slots;                         // Slots in the major cycle
+        uint16_t planned[POLL_SCHEDULER_SLOTS]; // Sum of budgets per slot (us)
+        volatile uint16_t measured[POLL_SCHEDULER_SLOTS];  // Worst slot time (us)
+
+        // Timer state
+        bool primed;
+        uint16_t slot;
+        uint32_t grid_us;                       // Nominal time of the current slot
+        volatile uint32_t slot_overruns;
+        volatile uint32_t missed_ticks;
+
+        static uint64_t gcd(uint64_t a, uint64_t b){
+            while (b) {
+                uint64_t t = a % b;
+                a = b;
+                b = t;
+            }
+            return a;
+        }
+
+        static uint16_t clamp16(uint32_t v){
+            return v > 0xFFFF ? 0xFFFF : (uint16_t)v;
+        }
+
+        static void onTick(void *ctx){
+            ((poll_scheduler*)ctx)->tick();
+        }
+
+        // Runs of o in the skipped slots first .. first + len - 1 (mod slots)
+        uint32_t dueIn(const operation &o, uint32_t first, uint32_t len) const{
+            uint32_t ps = o.period_slots;
+            uint32_t offset = (o.phase + ps - first % ps) % ps;
+            return len > offset ? (len - 1 - offset) / ps + 1 : 0;
+        }
+
+        void run(operation &o){
+            uint32_t t0 = P::micros();
+            o.fn(o.ctx);
+            uint32_t took = P::micros() - t0;
+            o.runs = o.runs + 1;
+            if (took > o.max_us) {
+                o.max_us = clamp16(took);
+            }
+            if (took > o.budget_us) {
+                o.overruns = o.overruns + 1;
+            }
+        }
+
+    public:
+        poll_scheduler() : count(0), base_us(0), slots(0), primed(false), slot(0), grid_us(0),
+                           slot_overruns(0), missed_ticks(0) {}
+
+        ~poll_scheduler() { end(); }
+
+        /** Register an operation
+         *
+         *  @param fn           Operation (timer context)
+         *  @param ctx          Passed back to fn
+         *  @param period_us    Period
+         *  @param budget_us    Time it may take per run, 0 to measure it at begin()
+         *  @return             Operation index for getOperationStats(), -1 if full
+         */
+        int addOperation(poll_operation fn, void *ctx, uint32_t period_us, uint16_t budget_us = 0){
+            if (count >= POLL_SCHEDULER_OPS || !period_us || !fn) {
+                return -1;
+            }
+            operation &o = ops[count];
+            o.fn = fn;
+            o.ctx = ctx;
+            o.period_us = period_us;
+            o.budget_us = budget_us;
+            o.period_slots = 0;
+            o.phase = 0;
+            return count++;
+        }
+
+        /** Build the static schedule (begin() calls it)
+         *
+         *  Operations without a budget are run POLL_SCHEDULER_PROBES times
+         *  here, in the caller's context, to measure one.
+         *
+         *  @return     POLL_SCHEDULER_OK, _OVERLOADED, _NO_OPS or _TOO_MANY_SLOTS
+         */
+        poll_scheduler_status build(){
+            if (!count) {
+                return POLL_SCHEDULER_NO_OPS;
+            }
+
+            uint32_t base = ops[0].period_us;
+            for (uint8_t i = 1; i < count; i++) {
+                base = (uint32_t)gcd(base, ops[i].period_us);
+            }
+            uint64_t major = ops[0].period_us;
+            for (uint8_t i = 1; i < count && major / base <= POLL_SCHEDULER_SLOTS; i++) {
+                major = major / gcd(major, ops[i].period_us) * ops[i].period_us;
+            }
+            if (major / base > POLL_SCHEDULER_SLOTS) {
+                return POLL_SCHEDULER_TOO_MANY_SLOTS;
+            }
+            base_us = base;
+            slots = (uint16_t)(major / base);
+
+            for (uint8_t i = 0; i < count; i++) {
+                operation &o = ops[i];
+                o.period_slots = (uint16_t)(o.period_us / base);
+                if (!o.budget_us) {
+                    uint32_t worst = 1;
+                    for (int k = 0; k < POLL_SCHEDULER_PROBES; k++) {
+                        uint32_t t0 = P::micros();
+                        o.fn(o.ctx);
+                        uint32_t took = P::micros() - t0;
+                        if (took > worst) {
+                            worst = took;
+                        }
+                    }
+                    o.budget_us = clamp16(worst);
+                }
+            }
+
+            // Rate-monotonic order (insertion sort, stable)
+            for (uint8_t i = 0; i < count; i++) {
+                uint8_t j = i;
+                while (j > 0 && ops[order[j - 1]].period_us > ops[i].period_us) {
+                    order[j] = order[j - 1];
+                    j--;
+                }
+                order[j] = i;
+            }
+
+            // Place each operation on the phase whose busiest slot is least loaded
+            for (uint16_t s = 0; s < slots; s++) {
+                planned[s] = 0;
+            }
+            poll_scheduler_status status = POLL_SCHEDULER_OK;
+            for (uint8_t i = 0; i < count; i++) {
+                operation &o = ops[order[i]];
+                uint32_t best_peak = 0xFFFFFFFF;
+                for (uint16_t phase = 0; phase < o.period_slots; phase++) {
+                    uint32_t peak = 0;
+                    for (uint32_t s = phase; s < slots; s += o.period_slots) {
+                        if (planned[s] > peak) {
+                            peak = planned[s];
+                        }
+                    }
+                    if (peak < best_peak) {
+                        best_peak = peak;
+                        o.phase = phase;
+                    }
+                }
+                for (uint32_t s = o.phase; s < slots; s += o.period_slots) {
+                    planned[s] = clamp16((uint32_t)planned[s] + o.budget_us);
+                    if (planned[s] > base_us) {
+                        status = POLL_SCHEDULER_OVERLOADED;
+                    }
+                }
+            }
+            return status;
+        }
+
+        /** Build the schedule and start it
+         *
+         *  An overloaded schedule is started anyway; its overruns show up
+         *  in the statistics.
+         *
+         *  @return     Result of build(), or POLL_SCHEDULER_TIMER_FAILED
+         */
+        poll_scheduler_status begin(){
+            end();
+            poll_scheduler_status status = build();
+            if (status != POLL_SCHEDULER_OK && status != POLL_SCHEDULER_OVERLOADED) {
+                return status;
+            }
+            resetStats();
+            primed = false;
+            slot = 0;
+            if (!timer.start(base_us, onTick, this)) {
+                return POLL_SCHEDULER_TIMER_FAILED;
+            }
+            return status;
+        }
+
+        /** Stop the schedule */
+        void end(){
+            timer.stop();
+        }
+
+        /** Run one slot (called by the timer; public for tests) */
+        void tick(){
+            uint32_t now = P::micros();
+
+            // Follow the clock: a late tick skips the slots it missed
+            if (!primed) {
+                primed = true;
+                grid_us = now;
+            } else {
+                uint32_t advance = (now - grid_us + base_us / 2) / base_us;
+                if (advance < 1) {
+                    advance = 1;
+                }
+                if (advance > 1) {
+                    missed_ticks = missed_ticks + advance - 1;
+                    for (uint8_t i = 0; i < count; i++) {
+                        operation &o = ops[i];
+                        o.missed = o.missed + dueIn(o, (slot + 1) % slots, advance - 1);
+                    }
+                }
+                grid_us += advance * base_us;
+                slot = (uint16_t)((slot + advance) % slots);
+            }
+
+            for (uint8_t i = 0; i < count; i++) {
+                operation &o = ops[order[i]];
+                if (slot % o.period_slots == o.phase) {
+                    run(o);
+                }
+            }
+
+            uint32_t took = P::micros() - now;
+            if (took > measured[slot]) {
+                measured[slot] = clamp16(took);
+            }
+            if (took > base_us) {
+                slot_overruns = slot_overruns + 1;
+            }
+        }
+
+        /** Slot length (us), 0 before build() */
+        uint32_t getSlotMicros() const { return base_us; }
+
+        /** Slots in the major cycle, 0 before build() */
+        uint16_t getSlots() const { return slots; }
+
+        /** Planned time of a slot: sum of the budgets placed in it (us) */
+        uint16_t getSlotPlanned(uint16_t s) const { return s < slots ? planned[s] : 0; }
+
+        /** Worst measured time of a slot (us) */
+        uint16_t getSlotMeasured(uint16_t s) const { return s < slots ? measured[s] : 0; }
+
+        /** Planned bus / CPU utilization over the major cycle (per mille) */
+        uint16_t getUtilization() const{
+            uint32_t permille = 0;
+            for (uint8_t i = 0; i < count; i++) {
+                permille += (uint32_t)ops[i].budget_us * 1000 / ops[i].period_us;
+            }
+            return clamp16(permille);
+        }
+
+        /** Slots that took longer than the slot length */
+        uint32_t getSlotOverruns() const { return slot_overruns; }
+
+        /** Timer ticks that never ran */
+        uint32_t getMissedTicks() const { return missed_ticks; }
+
+        /** Get one operation's statistics
+         *
+         *  @param idx      Index returned by addOperation()
+         *  @param stats    Statistics
+         *  @return         false if idx is not registered
+         */
+        bool getOperationStats(int idx, poll_operation_stats *stats) const{
+            if (idx < 0 || idx >= count) {
+                return false;
+            }
+            const operation &o = ops[idx];
+            stats->period_us = o.period_us;
+            stats->budget_us = o.budget_us;
+            stats->phase = o.phase;
+            stats->runs = o.runs;
+            stats->overruns = o.overruns;
+            stats->missed = o.missed;
+            stats->max_us = o.max_us;
+            return true;
+        }
+
+        /** Restart the measurements (the schedule is kept) */
+        void resetStats(){
+            for (uint8_t i = 0; i < count; i++) {
+                ops[i].runs = 0;
+                ops[i].overruns = 0;
+                ops[i].missed = 0;
+                ops[i].max_us = 0;
+            }
+            for (uint16_t s = 0; s < slots; s++) {
+                measured[s] = 0;
+            }
+            slot_overruns = 0;
+            missed_ticks = 0;
+        }
+};
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file snapshot_ring.h
+ * @brief Wait-free single-producer / single-consumer buffers for samples
+ *
+ * snapshot_ring<T, N> queues up to N - 1 records for a consumer that
+ * drains them in order. When it is full, push() rejects the new record
+ * and counts it: the ring keeps the oldest records, not the latest, and
+ * the consumer never sees a torn or reordered history. Use
+ * snapshot_latest for the newest value.
+ *
+ * snapshot_latest<T> holds only the newest record (sequence lock): the
+ * writer never waits, the reader retries if the writer got in between.
+ *
+ * The producer is a timer callback (interrupt or task, possibly on the
+ * other core), the consumer is the main loop. Each index is written by
+ * one side only and published with a release store / read with an
+ * acquire load, so neither side blocks, masks interrupts or takes a
+ * full barrier. Each side also keeps a copy of the other side's index
+ * and only reloads it when the ring looks full (producer) or empty
+ * (consumer), which keeps the two cores off each other's cache line
+ * while the ring is neither.
+ */
+
+#ifndef _SNAPSHOT_RING_H
+#define _SNAPSHOT_RING_H
+
+#include <stdint.h>
+
+/** Index alignment: one cache line where there are data caches */
+#ifndef SNAPSHOT_CACHE_LINE
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+#define SNAPSHOT_CACHE_LINE     64
+#else
+#define SNAPSHOT_CACHE_LINE     4
+#endif
+#endif
+
+#define SNAPSHOT_LOAD(x)        __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define SNAPSHOT_STORE(x, v)    __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+template <class T, uint16_t N>
+class snapshot_ring{
+    private:
+        T records[N];
+
+        // Producer side
+        alignas(SNAPSHOT_CACHE_LINE) uint16_t head;     // Written by push()
+        uint16_t tail_cache;                            // Last tail seen by push()
+        uint32_t dropped;
+
+        // Consumer side
+        alignas(SNAPSHOT_CACHE_LINE) uint16_t tail;     // Written by pop()
+        uint16_t head_cache;                            // Last head seen by pop()
+
+    public:
+        snapshot_ring() : head(0), tail_cache(0), dropped(0), tail(0), head_cache(0) {
+            static_assert((N & (N - 1)) == 0, "snapshot_ring size must be a power of two");
+        }
+
+        /** Add a record (producer)
+         *
+         *  @param rec  Record
+         *  @return     false if full (record dropped)
+         */
+        bool push(const T &rec){
+            uint16_t h = head;
+            uint16_t next = (h + 1) & (N - 1);
+            if (next == tail_cache) {
+                tail_cache = SNAPSHOT_LOAD(tail);
+                if (next == tail_cache) {
+                    __atomic_store_n(&dropped, dropped + 1, __ATOMIC_RELAXED);
+                    return false;
+                }
+            }
+            records[h] = rec;
+            SNAPSHOT_STORE(head, next);
+            return true;
+        }
+
+        /** Take the oldest record (consumer)
+         *
+         *  @param rec  Record
+         *  @return     false if empty
+         */
+        bool pop(T *rec){
+            uint16_t t = tail;
+            if (t == head_cache) {
+                head_cache = SNAPSHOT_LOAD(head);
+                if (t == head_cache) {
+                    return false;
+                }
+            }
+            *rec = records[t];
+            SNAPSHOT_STORE(tail, (uint16_t)((t + 1) & (N - 1)));
+            return true;
+        }
+
+        /** Records waiting (consumer) */
+        uint16_t size() const { return (SNAPSHOT_LOAD(head) - tail) & (N - 1); }
+
+        /** Records dropped because the ring was full */
+        uint32_t getDropped() const { return __atomic_load_n(&dropped, __ATOMIC_RELAXED); }
+};
+
+template <class T>
+class snapshot_latest{
+    private:
+        T record;
+        uint32_t seq;               // Odd while the writer is copying
+
+    public:
+        snapshot_latest() : seq(0) {}
+
+        /** Publish a record (producer) */
+        void write(const T &rec){
+            uint32_t s = seq;
+            __atomic_store_n(&seq, s + 1, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            record = rec;
+            SNAPSHOT_STORE(seq, s + 2);
+        }
+
+        /** Copy the newest record (consumer)
+         *
+         *  @param rec  Record
+         *  @return     false if nothing was written yet
+         */
+        bool read(T *rec) const{
+            uint32_t s;
+            do {
+                while ((s = SNAPSHOT_LOAD(seq)) & 1) {
+                }
+                *rec = record;
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            } while (__atomic_load_n(&seq, __ATOMIC_RELAXED) != s);
+            return s != 0;
+        }
+};
+
+#endif
@@ -3,7 +3,26 @@
  * Two encoders support
  *
  * - Configures two LS7366R for 4x quadrature, 32-bit counter, free-run
- * - Reads count periodically and prints via Serial
+ * - Polls on core 0 from a static schedule (poll_scheduler): both counts
+ *   at SAMPLE_RATE_HZ (encoder_sampler), each STR at STATUS_RATE_HZ
+ * - loop() on core 1 drains the samples and streams them as binary
+ *   telemetry frames (telemetry.h): every sample, delta-encoded, with the
+ *   STR bytes, plus a statistics frame every second. Decode a capture with
+ *   tools/telemetry_decode. Frames are dropped (and counted) rather than
+ *   waiting when the UART buffer is full.
+ *
+ * Only the polling task touches the SPI bus once setup() is done. Serial
+ * commands (command_parser.h) are parsed byte by byte in loop() and queued;
+ * the polling task runs them one bus step (one register write, reset or
+ * status clear) per COMMAND_PERIOD_US, after the counts of that slot and
+ * within its spare time, so a reset or reconfigure never delays a sample:
+ *
+ *   z / 1 / 2       clear both / encoder 1 / encoder 2
+ *   r               print the counts (text frame)
+ *   s <hz>          sample rate (SAMPLE_RATE_HZ / n)
+ *   c <m> <0> <1>   write MDR0 / MDR1 of the encoders in mask m
+ *   t <n>           stream only the next n samples; t 0 streams all
+ *   p               per-call cycle profile (text frames, built with OP_PROFILE)
  *
  * Connections (default VSPI on ESP32):
  *   SCK  -> GPIO 18
@@ -18,22 +37,195 @@
  * Encoder 2: A/B/Z to LS7366R #2
  */
 
+// Acquisition on core 0; the Arduino loop() runs on core 1
+#define PLATFORM_TIMER_CORE  0
+
 #include <Arduino.h>
 #include <SPI.h>
 #include "LS7366R_Single.h"
+#include "platform_arduino.h"
+#include "encoder_sampler.h"
+#include "poll_scheduler.h"
+#include "telemetry.h"
+#include "command_parser.h"
+#ifdef OP_PROFILE
+#include "op_profile.h"
+#endif
 
 // --- Pin configuration ---
 #define LS7366_CS_PIN_1  5   // Encoder 1
 #define LS7366_CS_PIN_2  15  // Encoder 2
 
+// --- Polling ---
+#define SAMPLE_RATE_HZ   2000  // Two syncs ~260 us at 500 kHz SPI
+#define STATUS_RATE_HZ   10
+#define COMMAND_PERIOD_US 2000   // One command step per 2 ms
+#define COMMAND_BUDGET_US 60     // Longest step: one register write, ~45 us
+#define COMMAND_QUEUE    8
+
+// --- Telemetry ---
+#define SERIAL_BAUD      115200
+#define FRAME_SAMPLES    20    // Samples per frame (10 ms at 2 kHz)
+#define FRAME_MAX_MS     50    // Send a partial frame after this long
+#define COUNTERS_MS      1000
+
+// Snapshot slots
+#define VAL_COUNT_1      0
+#define VAL_COUNT_2      1
+#define VAL_STREAM       2     // 1 if the sample is to be streamed
+
+#define STREAM_ALL       0xFFFFFFFF
+
 // --- Library objects ---
 LS7366R_Single encoder1(LS7366_CS_PIN_1);
 LS7366R_Single encoder2(LS7366_CS_PIN_2);
 
+encoder_sampler<arduino_platform> sampler;
+poll_scheduler<arduino_platform> scheduler;
+telemetry_encoder telemetry(2);
+command_parser parser;
+
+// Parsed commands, loop() -> polling task
+snapshot_ring<serial_command, COMMAND_QUEUE> commands;
+
+struct channel {
+  LS7366R_Single *encoder;
+  uint8_t mask_bit;         // Bit in command masks
+  volatile uint8_t status;  // Last STR read
+};
+
+channel channel1 = { &encoder1, 0x01, 0 };
+channel channel2 = { &encoder2, 0x02, 0 };
+channel *channels[] = { &channel1, &channel2 };
+
+// Polling task only
+uint32_t sample_divider = 1;  // Tick the sampler every n-th count slot
+uint32_t sample_phase = 0;
+uint32_t stream_left = STREAM_ALL;
+
+// Sampler sources and scheduled operations (core 0)
+int32_t readChannelCount(void *ctx) {
+  channel *ch = (channel *)ctx;
+  ch->encoder->sync();
+  return ch->encoder->getCount();
+}
+
+int32_t readStreamFlag(void *ctx) {
+  (void)ctx;
+  if (stream_left == STREAM_ALL) {
+    return 1;
+  }
+  if (stream_left) {
+    stream_left--;
+    return 1;
+  }
+  return 0;
+}
+
+void sampleCounts(void *ctx) {
+  if (++sample_phase >= sample_divider) {
+    sample_phase = 0;
+    ((encoder_sampler<arduino_platform> *)ctx)->tick();
+  }
+}
+
+uint32_t dividerFor(uint32_t rate_hz) {
+  uint32_t n = SAMPLE_RATE_HZ / rate_hz;
+  return n ? n : 1;
+}
+
+// Command in progress: one bus step per run, so a run never outgrows its
+// budget. reconfigure() would block ~10 ms per chip in its settle delays;
+// here the steps are COMMAND_PERIOD_US apart, which covers the settling.
+enum command_step {
+  STEP_MDR0 = 0,    // Reconfigure only
+  STEP_MDR1,        // Reconfigure only
+  STEP_CLEAR,       // Reset only
+  STEP_STATUS,
+  STEP_DONE
+};
+
+serial_command active;
+bool command_active = false;
+uint8_t command_channel = 0;
+uint8_t command_step = STEP_DONE;
+
+// Next channel of the active command's mask at or after command_channel
+bool nextChannel() {
+  while (command_channel < 2 && !(active.arg[0] & channels[command_channel]->mask_bit)) {
+    command_channel++;
+  }
+  if (command_channel >= 2) {
+    return false;
+  }
+  command_step = active.type == COMMAND_RECONFIGURE ? STEP_MDR0 : STEP_CLEAR;
+  return true;
+}
+
+// One step of a queued command per run, after the counts in its slot
+void runCommand(void *ctx) {
+  (void)ctx;
+  if (!command_active) {
+    if (!commands.pop(&active)) {
+      return;
+    }
+    command_channel = 0;
+    switch (active.type) {
+      case COMMAND_RESET:
+      case COMMAND_RECONFIGURE:
+        command_active = nextChannel();
+        break;
+      case COMMAND_SET_RATE:
+        sample_divider = dividerFor(active.arg[0]);
+        sample_phase = 0;
+        sampler.setRate(SAMPLE_RATE_HZ / sample_divider);
+        return;
+      case COMMAND_CAPTURE:
+        stream_left = active.arg[0] ? active.arg[0] : STREAM_ALL;
+        return;
+      default:
+        return;
+    }
+    if (!command_active) {
+      return;
+    }
+  }
+
+  LS7366R_Single *encoder = channels[command_channel]->encoder;
+  switch (command_step) {
+    case STEP_MDR0:
+      encoder->setMDR0((uint8_t)active.arg[1]);
+      command_step = STEP_MDR1;
+      break;
+    case STEP_MDR1:
+      encoder->setMDR1((uint8_t)active.arg[2]);
+      command_step = STEP_STATUS;
+      break;
+    case STEP_CLEAR:
+      encoder->reset();
+      command_step = STEP_STATUS;
+      break;
+    default:
+      encoder->clearStatus();
+      command_channel++;
+      command_active = nextChannel();
+      break;
+  }
+}
+
+void readChannelStatus(void *ctx) {
+  channel *ch = (channel *)ctx;
+  ch->status = ch->encoder->readStatus();
+}
+
 void setup() {
-  Serial.begin(115200);
+  Serial.setTxBufferSize(1024);  // Room for several frames: sendFrame() never waits
+  Serial.begin(SERIAL_BAUD);
   delay(200);
   Serial.println("\nLS7366R ESP32 Test - Two Encoders");
+#ifdef OP_PROFILE
+  op_profile_begin();
+#endif
 
   if (encoder1.begin()) {
     Serial.println("LS7366R #1 initialized (CS=5)");
@@ -62,53 +254,136 @@ void setup() {
   Serial.print(encoder2.readStatus(), HEX);
   Serial.print(" Count=");
   Serial.println(encoder2.getCount());
+
+  // Hand the bus to the polling task (budgets are measured here)
+  sampler.addSource(readChannelCount, &channel1);
+  sampler.addSource(readChannelCount, &channel2);
+  sampler.addSource(readStreamFlag, 0);
+  sampler.setRate(SAMPLE_RATE_HZ);
+  scheduler.addOperation(sampleCounts, &sampler, 1000000 / SAMPLE_RATE_HZ);
+  scheduler.addOperation(readChannelStatus, &channel1, 1000000 / STATUS_RATE_HZ);
+  scheduler.addOperation(readChannelStatus, &channel2, 1000000 / STATUS_RATE_HZ);
+  scheduler.addOperation(runCommand, 0, COMMAND_PERIOD_US, COMMAND_BUDGET_US);
+
+  poll_scheduler_status status = scheduler.begin();
+  Serial.print("Schedule: ");
+  Serial.print(scheduler.getSlots());
+  Serial.print(" slots of ");
+  Serial.print(scheduler.getSlotMicros());
+  Serial.print(" us, utilization ");
+  Serial.print(scheduler.getUtilization() / 10);
+  Serial.println("%");
+  if (status == POLL_SCHEDULER_OVERLOADED) {
+    Serial.println("Schedule overloaded: slots will overrun!");
+  } else if (status != POLL_SCHEDULER_OK) {
+    Serial.println("Scheduler start failed!");
+  }
+
+  // End of text: binary telemetry from here on
+  Serial.println("Streaming telemetry (tools/telemetry_decode)");
+  Serial.write((uint8_t)0);
+}
+
+unsigned long lastFrame = 0;
+unsigned long lastCounters = 0;
+uint32_t received = 0;
+uint32_t frames_dropped = 0;
+
+// Send the frame at telemetry.getFrame() if it fits the UART buffer now
+void sendFrame(uint16_t length) {
+  if (length == 0) {
+    return;
+  }
+  if (Serial.availableForWrite() >= length) {
+    Serial.write(telemetry.getFrame(), length);
+  } else {
+    frames_dropped++;
+  }
+  lastFrame = millis();
+}
+
+void sendText(const char *text) {
+  sendFrame(telemetry.buildText(text));
 }
 
-unsigned long lastPrint = 0;
+// One text frame per profiled operation that has run
+void sendProfile() {
+#ifdef OP_PROFILE
+  for (uint8_t op = 0; op < OP_PROFILE_OPS; op++) {
+    op_profile_stats s;
+    if (!op_profile_read(op, &s) || s.count == 0) {
+      continue;
+    }
+    char text[96];
+    snprintf(text, sizeof(text), "%s n=%lu min=%lu mean=%lu p99<=%lu max=%lu ns",
+             op_profile_name(op), (unsigned long)s.count,
+             (unsigned long)op_profile_ns(s.min), (unsigned long)op_profile_ns(op_profile_mean(&s)),
+             (unsigned long)op_profile_ns(op_profile_percentile(&s, 990)),
+             (unsigned long)op_profile_ns(s.max));
+    sendText(text);
+  }
+#else
+  sendText("Built without OP_PROFILE.");
+#endif
+}
 
 void loop() {
-  // Periodically print counts
-  if (millis() - lastPrint >= 250) {
-    lastPrint = millis();
-
-    encoder1.sync();
-    encoder2.sync();
-
-    Serial.print("Enc1: ");
-    Serial.print(encoder1.getCount());
-    Serial.print(" (STR=0x");
-    Serial.print(encoder1.readStatus(), HEX);
-    Serial.print(") | Enc2: ");
-    Serial.print(encoder2.getCount());
-    Serial.print(" (STR=0x");
-    Serial.print(encoder2.readStatus(), HEX);
-    Serial.println(")");
-  }
-
-  // Serial commands
-  if (Serial.available()) {
-    char c = Serial.read();
-    if (c == 'z' || c == 'Z') {
-      encoder1.reset();
-      encoder2.reset();
-      encoder1.clearStatus();
-      encoder2.clearStatus();
-      Serial.println("Both counters and status cleared.");
-    } else if (c == '1') {
-      encoder1.reset();
-      encoder1.clearStatus();
-      Serial.println("Encoder 1 cleared.");
-    } else if (c == '2') {
-      encoder2.reset();
-      encoder2.clearStatus();
-      Serial.println("Encoder 2 cleared.");
-    } else if (c == 'r' || c == 'R') {
-      encoder1.sync();
-      encoder2.sync();
-      Serial.print("Enc1=");
-      Serial.print(encoder1.getCount());
-      Serial.print(" Enc2=");
-      Serial.println(encoder2.getCount());
+  // Drain the samples into telemetry frames
+  encoder_snapshot snap;
+  while (sampler.read(&snap)) {
+    received++;
+    if (!snap.value[VAL_STREAM]) {
+      continue;
+    }
+    telemetry.setStatus(0, channel1.status);
+    telemetry.setStatus(1, channel2.status);
+    if (!telemetry.addSample(snap.time_us, &snap.value[VAL_COUNT_1])) {
+      sendFrame(telemetry.finish());
+      telemetry.addSample(snap.time_us, &snap.value[VAL_COUNT_1]);
+    }
+    if (telemetry.getSamples() >= FRAME_SAMPLES) {
+      sendFrame(telemetry.finish());
+    }
+  }
+  if (telemetry.getSamples() && millis() - lastFrame >= FRAME_MAX_MS) {
+    sendFrame(telemetry.finish());
+  }
+
+  // Statistics: samples, slot overruns, sampler drops, telemetry drops, bad commands
+  if (millis() - lastCounters >= COUNTERS_MS) {
+    lastCounters = millis();
+
+    encoder_sampler_stats stats;
+    sampler.getStats(&stats);
+    uint32_t counters[5] = { received, scheduler.getSlotOverruns(), stats.dropped, frames_dropped,
+                             parser.getErrors() };
+    sendFrame(telemetry.buildCounters(counters, 5));
+  }
+
+  // Serial commands: parse what has arrived, queue for the polling task
+  serial_command cmd;
+  while (Serial.available()) {
+    if (!parser.push(Serial.read(), &cmd)) {
+      continue;
+    }
+    if (cmd.type == COMMAND_READ) {
+      if (sampler.readLatest(&snap)) {
+        char text[48];
+        snprintf(text, sizeof(text), "Enc1=%ld Enc2=%ld",
+                 (long)snap.value[VAL_COUNT_1], (long)snap.value[VAL_COUNT_2]);
+        sendText(text);
+      }
+    } else if (cmd.type == COMMAND_PROFILE) {
+      sendProfile();
+    } else if (!commands.push(cmd)) {
+      sendText("Command queue full.");
+    } else if (cmd.type == COMMAND_SET_RATE) {
+      char text[48];
+      snprintf(text, sizeof(text), "Sample rate %lu Hz.",
+               (unsigned long)(SAMPLE_RATE_HZ / dividerFor(cmd.arg[0])));
+      sendText(text);
+    } else {
+      sendText("Command queued.");
     }
   }
 }
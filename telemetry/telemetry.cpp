@@ -0,0 +1,331 @@
+/**
+ * @file telemetry.cpp
+ * @brief Implementation of binary telemetry frames
+ */
+
+#include "telemetry.h"
+
+#define TELEMETRY_SAMPLES_HEADER    4       // type, seq, channels, samples
+
+static uint32_t zigzag(int32_t v){
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v){
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static void putU32(uint8_t *p, uint32_t v){
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t getU32(const uint8_t *p){
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool getVarint(const uint8_t *p, uint16_t len, uint16_t *pos, uint32_t *v){
+    uint32_t result = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (*pos >= len) {
+            return false;
+        }
+        uint8_t b = p[(*pos)++];
+        result |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint16_t telemetry_crc16(const uint8_t *data, uint16_t len){
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+uint16_t telemetry_cobs_encode(const uint8_t *in, uint16_t len, uint8_t *out){
+    uint16_t code_at = 0;
+    uint16_t o = 1;
+    uint8_t code = 1;
+    for (uint16_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+        } else {
+            out[o++] = in[i];
+            if (++code == 0xFF) {
+                out[code_at] = code;
+                code_at = o++;
+                code = 1;
+            }
+        }
+    }
+    out[code_at] = code;
+    return o;
+}
+
+int32_t telemetry_cobs_decode(const uint8_t *in, uint16_t len, uint8_t *out){
+    uint16_t i = 0;
+    uint16_t o = 0;
+    while (i < len) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > len) {
+            return -1;
+        }
+        for (uint8_t k = 1; k < code; k++) {
+            if (in[i] == 0) {
+                return -1;
+            }
+            out[o++] = in[i++];
+        }
+        if (code < 0xFF && i < len) {
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+/* ---------------------------------------------------------------- encoder */
+
+telemetry_encoder::telemetry_encoder(uint8_t channels)
+    : channels(channels > TELEMETRY_MAX_CHANNELS ? TELEMETRY_MAX_CHANNELS : (channels ? channels : 1)),
+      seq(0) {
+    for (uint8_t c = 0; c < TELEMETRY_MAX_CHANNELS; c++) {
+        status[c] = 0;
+    }
+    startSamples();
+}
+
+void telemetry_encoder::startSamples(){
+    payload[0] = TELEMETRY_SAMPLES;
+    payload[2] = channels;
+    length = TELEMETRY_SAMPLES_HEADER + channels;
+    samples = 0;
+    last_dt = 0;
+}
+
+void telemetry_encoder::putVarint(uint32_t v){
+    while (v >= 0x80) {
+        payload[length++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    payload[length++] = (uint8_t)v;
+}
+
+uint16_t telemetry_encoder::encodeFrame(uint8_t *data, uint16_t len){
+    uint16_t crc = telemetry_crc16(data, len);
+    data[len] = (uint8_t)crc;
+    data[len + 1] = (uint8_t)(crc >> 8);
+    uint16_t n = telemetry_cobs_encode(data, len + 2, frame);
+    frame[n] = 0;
+    return n + 1;
+}
+
+void telemetry_encoder::setStatus(uint8_t channel, uint8_t value){
+    if (channel < channels) {
+        status[channel] = value;
+    }
+}
+
+bool telemetry_encoder::addSample(uint32_t time_us, const int32_t *values){
+    // Worst case: 5-byte varints
+    uint16_t worst = samples ? 5 * (1 + channels) : 4 * (1 + channels);
+    if (samples == TELEMETRY_MAX_SAMPLES || length + worst > TELEMETRY_MAX_PAYLOAD) {
+        return false;
+    }
+
+    if (samples == 0) {
+        putU32(&payload[length], time_us);
+        length += 4;
+        for (uint8_t c = 0; c < channels; c++) {
+            putU32(&payload[length], (uint32_t)values[c]);
+            length += 4;
+        }
+    } else {
+        int32_t dt = (int32_t)(time_us - last_time_us);
+        putVarint(zigzag((int32_t)((uint32_t)dt - (uint32_t)last_dt)));
+        last_dt = dt;
+        for (uint8_t c = 0; c < channels; c++) {
+            putVarint(zigzag((int32_t)((uint32_t)values[c] - (uint32_t)last_value[c])));
+        }
+    }
+
+    last_time_us = time_us;
+    for (uint8_t c = 0; c < channels; c++) {
+        last_value[c] = values[c];
+    }
+    samples++;
+    return true;
+}
+
+uint16_t telemetry_encoder::finish(){
+    if (samples == 0) {
+        return 0;
+    }
+    payload[1] = seq++;
+    payload[3] = samples;
+    for (uint8_t c = 0; c < channels; c++) {
+        payload[TELEMETRY_SAMPLES_HEADER + c] = status[c];
+    }
+    uint16_t n = encodeFrame(payload, length);
+    startSamples();
+    return n;
+}
+
+uint16_t telemetry_encoder::buildCounters(const uint32_t *values, uint8_t count){
+    uint8_t data[3 + 4 * TELEMETRY_MAX_COUNTERS + 2];
+    if (count > TELEMETRY_MAX_COUNTERS) {
+        count = TELEMETRY_MAX_COUNTERS;
+    }
+    data[0] = TELEMETRY_COUNTERS;
+    data[1] = seq++;
+    data[2] = count;
+    for (uint8_t i = 0; i < count; i++) {
+        putU32(&data[3 + 4 * i], values[i]);
+    }
+    return encodeFrame(data, 3 + 4 * count);
+}
+
+uint16_t telemetry_encoder::buildText(const char *text){
+    uint8_t data[TELEMETRY_MAX_PAYLOAD + 2];
+    uint16_t len = 2;
+    data[0] = TELEMETRY_TEXT;
+    data[1] = seq++;
+    while (*text && len < TELEMETRY_MAX_PAYLOAD) {
+        data[len++] = (uint8_t)*text++;
+    }
+    return encodeFrame(data, len);
+}
+
+/* ---------------------------------------------------------------- decoder */
+
+telemetry_decoder::telemetry_decoder()
+    : block_length(0), overflowed(false), synced(false), next_seq(0), frame_length(0),
+      type(0), seq(0), channels(0), count(0) {
+    text[0] = 0;
+    stats = telemetry_decoder_stats();
+}
+
+bool telemetry_decoder::push(uint8_t byte){
+    if (byte != 0) {
+        if (block_length < sizeof(block)) {
+            block[block_length++] = byte;
+        } else {
+            overflowed = true;
+        }
+        return false;
+    }
+
+    bool ok = false;
+    if (overflowed) {
+        stats.overflow++;
+    } else if (block_length > 0) {
+        ok = parse();
+    }
+    block_length = 0;
+    overflowed = false;
+    return ok;
+}
+
+bool telemetry_decoder::parse(){
+    int32_t n = telemetry_cobs_decode(block, block_length, frame);
+    if (n < 4) {
+        stats.malformed++;
+        return false;
+    }
+    frame_length = (uint16_t)(n - 2);
+    uint16_t crc = (uint16_t)(frame[frame_length] | (frame[frame_length + 1] << 8));
+    if (crc != telemetry_crc16(frame, frame_length)) {
+        stats.bad_crc++;
+        return false;
+    }
+
+    bool ok = false;
+    switch (frame[0]) {
+        case TELEMETRY_SAMPLES:
+            ok = parseSamples();
+            break;
+        case TELEMETRY_COUNTERS:
+            count = frame_length >= 3 ? frame[2] : 0;
+            ok = frame_length >= 3 && count <= TELEMETRY_MAX_COUNTERS && frame_length == 3 + 4 * count;
+            for (uint8_t i = 0; ok && i < count; i++) {
+                counter[i] = getU32(&frame[3 + 4 * i]);
+            }
+            break;
+        case TELEMETRY_TEXT:
+            if (frame_length - 2 >= (int)sizeof(text)) {
+                break;
+            }
+            for (uint16_t i = 2; i < frame_length; i++) {
+                text[i - 2] = (char)frame[i];
+            }
+            text[frame_length - 2] = 0;
+            ok = true;
+            break;
+    }
+    if (!ok) {
+        stats.malformed++;
+        return false;
+    }
+
+    type = frame[0];
+    seq = frame[1];
+    if (synced) {
+        stats.lost += (uint8_t)(seq - next_seq);
+    }
+    next_seq = seq + 1;
+    synced = true;
+    stats.frames++;
+    return true;
+}
+
+bool telemetry_decoder::parseSamples(){
+    if (frame_length < TELEMETRY_SAMPLES_HEADER) {
+        return false;
+    }
+    channels = frame[2];
+    count = frame[3];
+    uint16_t pos = TELEMETRY_SAMPLES_HEADER + channels;
+    if (channels == 0 || channels > TELEMETRY_MAX_CHANNELS || count == 0 ||
+        pos + 4 * (1 + channels) > frame_length) {
+        return false;
+    }
+
+    for (uint8_t c = 0; c < channels; c++) {
+        status[c] = frame[TELEMETRY_SAMPLES_HEADER + c];
+    }
+    time_us[0] = getU32(&frame[pos]);
+    pos += 4;
+    for (uint8_t c = 0; c < channels; c++) {
+        value[0][c] = (int32_t)getU32(&frame[pos]);
+        pos += 4;
+    }
+
+    int32_t dt = 0;
+    for (uint8_t s = 1; s < count; s++) {
+        uint32_t v;
+        if (!getVarint(frame, frame_length, &pos, &v)) {
+            return false;
+        }
+        dt = (int32_t)((uint32_t)dt + (uint32_t)unzigzag(v));
+        time_us[s] = time_us[s - 1] + (uint32_t)dt;
+        for (uint8_t c = 0; c < channels; c++) {
+            if (!getVarint(frame, frame_length, &pos, &v)) {
+                return false;
+            }
+            value[s][c] = (int32_t)((uint32_t)value[s - 1][c] + (uint32_t)unzigzag(v));
+        }
+    }
+    return pos == frame_length;
+}
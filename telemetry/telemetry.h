@@ -0,0 +1,205 @@
+/**
+ * @file telemetry.h
+ * @brief Compact binary telemetry: delta-encoded sample frames, COBS + CRC-16
+ *
+ * Replaces formatted Serial.print() lines with binary frames built in a
+ * preallocated buffer. A frame carries a batch of samples (timestamp and
+ * up to TELEMETRY_MAX_CHANNELS counts) plus one status byte per channel:
+ *
+ *   type  seq  channels  samples  status[channels]
+ *   time_us (u32 LE)  value[channels] (i32 LE)          first sample, absolute
+ *   zz(dt - previous dt)  zz(dvalue)[channels]          following samples, varints
+ *   crc16 (LE)
+ *
+ * zz() is a zigzag LEB128 varint, so a sample on a steady grid whose counts
+ * moved by less than +-64 costs 1 + channels bytes. Every frame starts from
+ * absolute values: a lost frame loses only its own samples.
+ *
+ * The whole frame is COBS-encoded and ends with a 0x00 delimiter, so a
+ * receiver can start listening at any point and resynchronise on the next
+ * zero byte. The CRC (CRC-16/CCITT-FALSE) is taken over the unencoded frame.
+ *
+ * Other frame types:
+ * - TELEMETRY_COUNTERS: up to TELEMETRY_MAX_COUNTERS u32 values (statistics)
+ * - TELEMETRY_TEXT:     a short message (command replies)
+ *
+ * Sender:
+ *
+ *   telemetry_encoder tx(2);
+ *   tx.setStatus(0, str1);
+ *   if (!tx.addSample(snap.time_us, snap.value)) {
+ *       send(tx.getFrame(), tx.finish());
+ *       tx.addSample(snap.time_us, snap.value);
+ *   }
+ *
+ * Receiver (host tools): feed bytes to telemetry_decoder::push().
+ */
+
+#ifndef _TELEMETRY_H
+#define _TELEMETRY_H
+
+#include <stdint.h>
+
+/** Frame types */
+#define TELEMETRY_SAMPLES           0x01
+#define TELEMETRY_COUNTERS          0x02
+#define TELEMETRY_TEXT              0x03
+
+/** Limits */
+#define TELEMETRY_MAX_CHANNELS      4
+#define TELEMETRY_MAX_COUNTERS      8
+#define TELEMETRY_MAX_PAYLOAD       240     ///< Unencoded frame without CRC
+#define TELEMETRY_MAX_SAMPLES       255
+
+/** Encoded frame size: payload + CRC + COBS overhead + delimiter */
+#define TELEMETRY_MAX_FRAME         (TELEMETRY_MAX_PAYLOAD + 2 + (TELEMETRY_MAX_PAYLOAD + 2) / 254 + 2)
+
+/** CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) */
+uint16_t telemetry_crc16(const uint8_t *data, uint16_t len);
+
+/** COBS-encode len bytes (no delimiter)
+ *
+ *  @param out  At least len + len / 254 + 1 bytes
+ *  @return     Encoded length
+ */
+uint16_t telemetry_cobs_encode(const uint8_t *in, uint16_t len, uint8_t *out);
+
+/** Decode one COBS block (without its delimiter)
+ *
+ *  @param out  At least len bytes
+ *  @return     Decoded length, -1 if the block is malformed
+ */
+int32_t telemetry_cobs_decode(const uint8_t *in, uint16_t len, uint8_t *out);
+
+class telemetry_encoder{
+    private:
+        uint8_t channels;
+        uint8_t seq;
+        uint8_t status[TELEMETRY_MAX_CHANNELS];
+
+        // Sample frame being built
+        uint8_t payload[TELEMETRY_MAX_PAYLOAD + 2];
+        uint16_t length;
+        uint8_t samples;
+        uint32_t last_time_us;
+        int32_t last_dt;
+        int32_t last_value[TELEMETRY_MAX_CHANNELS];
+
+        uint8_t frame[TELEMETRY_MAX_FRAME];
+
+        void startSamples();
+        void putVarint(uint32_t v);
+        uint16_t encodeFrame(uint8_t *data, uint16_t len);
+
+    public:
+        /** Creates telemetry_encoder object with specific content.
+         *
+         *  @param channels     Values per sample (1 .. TELEMETRY_MAX_CHANNELS)
+         */
+        explicit telemetry_encoder(uint8_t channels);
+
+        /** Status byte of a channel, sent with each sample frame */
+        void setStatus(uint8_t channel, uint8_t value);
+
+        /** Append a sample to the current frame
+         *
+         *  @param time_us  When the values were taken (micros())
+         *  @param values   One value per channel
+         *  @return         false if the frame is full: finish() it and add again
+         */
+        bool addSample(uint32_t time_us, const int32_t *values);
+
+        /** Samples in the current frame */
+        uint8_t getSamples() const { return samples; }
+
+        /** Close the current sample frame
+         *
+         *  @return     Encoded length at getFrame(), 0 if there were no samples
+         */
+        uint16_t finish();
+
+        /** Build a counters frame (does not touch the sample frame)
+         *
+         *  @param values   Counters
+         *  @param count    Number of counters (at most TELEMETRY_MAX_COUNTERS)
+         *  @return         Encoded length at getFrame()
+         */
+        uint16_t buildCounters(const uint32_t *values, uint8_t count);
+
+        /** Build a text frame (does not touch the sample frame)
+         *
+         *  @param text     Message, truncated to fit one frame
+         *  @return         Encoded length at getFrame()
+         */
+        uint16_t buildText(const char *text);
+
+        /** Last encoded frame, delimiter included; valid until the next finish() / build*() */
+        const uint8_t *getFrame() const { return frame; }
+};
+
+/** Receive statistics */
+struct telemetry_decoder_stats{
+    uint32_t frames;        ///< Frames accepted
+    uint32_t bad_crc;       ///< CRC mismatch
+    uint32_t malformed;     ///< Bad COBS, unknown type or truncated frame
+    uint32_t overflow;      ///< Blocks longer than TELEMETRY_MAX_FRAME
+    uint32_t lost;          ///< Frames missing according to seq
+};
+
+class telemetry_decoder{
+    private:
+        uint8_t block[TELEMETRY_MAX_FRAME];
+        uint16_t block_length;
+        bool overflowed;
+        bool synced;            // A frame was seen, seq is meaningful
+        uint8_t next_seq;
+
+        uint8_t frame[TELEMETRY_MAX_FRAME];
+        uint16_t frame_length;
+
+        // Parsed frame
+        uint8_t type;
+        uint8_t seq;
+        uint8_t channels;
+        uint8_t count;
+        uint8_t status[TELEMETRY_MAX_CHANNELS];
+        uint32_t time_us[TELEMETRY_MAX_SAMPLES];
+        int32_t value[TELEMETRY_MAX_SAMPLES][TELEMETRY_MAX_CHANNELS];
+        uint32_t counter[TELEMETRY_MAX_COUNTERS];
+        char text[TELEMETRY_MAX_PAYLOAD];
+
+        telemetry_decoder_stats stats;
+
+        bool parse();
+        bool parseSamples();
+
+    public:
+        telemetry_decoder();
+
+        /** Feed one received byte
+         *
+         *  @return     true if it completed a valid frame (read it with the getters)
+         */
+        bool push(uint8_t byte);
+
+        uint8_t getType() const { return type; }
+        uint8_t getSeq() const { return seq; }
+
+        /** TELEMETRY_SAMPLES */
+        uint8_t getChannels() const { return channels; }
+        uint8_t getSamples() const { return count; }
+        uint8_t getStatus(uint8_t channel) const { return status[channel]; }
+        uint32_t getTime(uint8_t sample) const { return time_us[sample]; }
+        int32_t getValue(uint8_t sample, uint8_t channel) const { return value[sample][channel]; }
+
+        /** TELEMETRY_COUNTERS */
+        uint8_t getCounters() const { return count; }
+        uint32_t getCounter(uint8_t index) const { return counter[index]; }
+
+        /** TELEMETRY_TEXT (zero-terminated) */
+        const char *getText() const { return text; }
+
+        void getStats(telemetry_decoder_stats *out) const { *out = stats; }
+};
+
+#endif
@@ -0,0 +1,336 @@
+/**
+ * @file trace_replay.cpp
+ * @brief Host tool: replay a bus trace against the drivers
+ *
+ * Loads a bus_trace dump (bus_trace.h) and re-runs the driver calls that
+ * produced it, in the recorded order, against bus_replay devices that
+ * answer with the recorded MISO bytes:
+ *
+ *   LS7366R   LOAD OTR + RD OTR -> sync()          CLR CNTR -> reset()
+ *             CLR STR -> clearStatus()             RD STR -> readStatus()
+ *             WR MDR0 + WR MDR1 -> reconfigure()   WR MDR1 -> enable() / disable()
+ *   AS5047P   RD ANGLECOM, ANGLEUNC, DIAAGC, NOP -> readSample()
+ *             RD x + RD NOP -> readRegister(x)     (also readAngleRaw())
+ *             RD ANGLECOM -> readAngleRawPipelined()
+ *             listen-only -> readAngleRaw()
+ *
+ * readAngleRawPipelined() is one frame when the driver has an ANGLECOM
+ * read in flight, two (priming + read) otherwise. The replay follows the
+ * driver's state, so the first pipelined read of a trace that starts in
+ * the middle of a run takes the next angle frame as its priming frame.
+ * Listen-only frames carry no command, so each one replays as a single
+ * readAngleRaw() whichever call produced it.
+ *
+ * Other frames (e.g. the steps of a register write) are skipped. For each
+ * call type it reports the runs, results that differ from the recorded
+ * responses, host CPU per call, and the bus time per call in the replay
+ * (host_sim virtual time) against the field recording. MOSI mismatches
+ * mean the driver no longer sends what it sent in the field. The exit
+ * code is 1 if anything differed, for use in regression scripts.
+ *
+ * AS5047P pins other than CS are not in the trace; the replay assigns
+ * free host_sim pins.
+ *
+ * Build and run on the host:
+ *   g++ -std=gnu++11 -O2 -I bench -I platform -I host -I host/arduino -I LS7366R -I as5047p -I bus \
+ *       tools/trace_replay.cpp host/host_sim.cpp host/bus_replay.cpp host/arduino/host_arduino.cpp \
+ *       LS7366R/LS7366R_Single.cpp bus/bus_trace.cpp -o trace_replay
+ *   ./trace_replay trace.bin
+ */
+
+#include <stdio.h>
+#include "bench.h"
+#include "host_sim.h"
+#include "host_arduino.h"
+#include "platform_host.h"
+#include "bus_replay.h"
+#include "LS7366R_Single.h"
+#include "as5047p_core.h"
+
+#define REPLAY_MAX_BYTES    (4 * 1024 * 1024)
+#define REPLAY_MAX_RECORDS  65535
+#define REPLAY_MAX_DEVICES  8
+
+enum replay_op{
+    OP_SYNC,
+    OP_RESET,
+    OP_CLEAR_STATUS,
+    OP_READ_STATUS,
+    OP_RECONFIGURE,
+    OP_WRITE_MDR1,
+    OP_READ_SAMPLE,
+    OP_READ_REGISTER,
+    OP_READ_ANGLE,
+    OP_LISTEN_ANGLE,
+    OP_SKIPPED,
+    OP_COUNT
+};
+
+static const char *op_names[OP_COUNT] = {
+    "LS7366R sync", "LS7366R reset", "LS7366R clearStatus", "LS7366R readStatus",
+    "LS7366R reconfigure", "LS7366R enable/disable", "AS5047P readSample",
+    "AS5047P readRegister", "AS5047P readAnglePipelined", "AS5047P readAngleRaw (listen)", "skipped frames"
+};
+
+struct op_stats{
+    uint32_t runs;
+    uint32_t wrong;         // Result differs from the recorded response
+    uint64_t host_ns;
+    uint64_t bus_ns;        // Replay, virtual time
+    uint64_t field_us;      // Recording: first CS low to last CS high
+};
+
+struct replay_device{
+    uint8_t device;
+    uint8_t kind;
+    bus_replay *replay;
+    LS7366R_Single *counter;
+    as5047p_core<host_platform> *sensor;
+};
+
+static uint8_t dump[REPLAY_MAX_BYTES];
+static bus_trace_record records[REPLAY_MAX_RECORDS];
+static bool consumed[REPLAY_MAX_RECORDS];
+static op_stats stats[OP_COUNT];
+
+static uint16_t word(const uint8_t *b){
+    return (uint16_t)((b[0] << 8) | b[1]);
+}
+
+// LS7366R: which call produced the frames starting at the next one, and how many
+static replay_op inferCounter(bus_replay *r, uint8_t *frames){
+    const bus_trace_record *a = r->peek(0);
+    const bus_trace_record *b = r->peek(1);
+    uint8_t cmd = a->length ? a->out[0] : 0xFF;
+    *frames = 1;
+    if (cmd == (LS7366R_CMD_LOAD | LS7366R_REG_OTR) && b && b->length == 5 &&
+        b->out[0] == (LS7366R_CMD_READ | LS7366R_REG_OTR)) {
+        *frames = 2;
+        return OP_SYNC;
+    }
+    if (cmd == (LS7366R_CMD_WRITE | LS7366R_REG_MDR0) && a->length == 2 && b && b->length == 2 &&
+        b->out[0] == (LS7366R_CMD_WRITE | LS7366R_REG_MDR1)) {
+        *frames = 2;
+        return OP_RECONFIGURE;
+    }
+    if (cmd == (LS7366R_CMD_CLEAR | LS7366R_REG_CNTR) && a->length == 1) return OP_RESET;
+    if (cmd == (LS7366R_CMD_CLEAR | LS7366R_REG_STR) && a->length == 1) return OP_CLEAR_STATUS;
+    if (cmd == (LS7366R_CMD_READ | LS7366R_REG_STR) && a->length == 2) return OP_READ_STATUS;
+    if (cmd == (LS7366R_CMD_WRITE | LS7366R_REG_MDR1) && a->length == 2) return OP_WRITE_MDR1;
+    return OP_SKIPPED;
+}
+
+// AS5047P: 16-bit frames
+static replay_op inferSensor(bus_replay *r, const as5047p_core<host_platform> *sensor, uint8_t *frames){
+    const bus_trace_record *f[4];
+    for (uint8_t i = 0; i < 4; i++) {
+        f[i] = r->peek(i);
+        if (f[i] && f[i]->length != 2) {
+            f[i] = 0;
+        }
+    }
+    *frames = 1;
+    if (!f[0]) {
+        return OP_SKIPPED;
+    }
+    if (f[0]->kind & BUS_TRACE_NO_MOSI) {
+        return OP_LISTEN_ANGLE;
+    }
+
+    uint16_t cmd[4];
+    for (uint8_t i = 0; i < 4; i++) {
+        cmd[i] = f[i] ? (uint16_t)(word(f[i]->out) & 0x7FFF) : 0;
+    }
+    const uint16_t read = AS5047P_FRAME_READ;
+    if (f[3] && cmd[0] == (read | AS5047P_REG_ANGLECOM) && cmd[1] == (read | AS5047P_REG_ANGLEUNC) &&
+        cmd[2] == (read | AS5047P_REG_DIAAGC) && cmd[3] == (read | AS5047P_REG_NOP)) {
+        *frames = 4;
+        return OP_READ_SAMPLE;
+    }
+    if (f[1] && (cmd[0] & read) && cmd[1] == (read | AS5047P_REG_NOP)) {
+        *frames = 2;
+        return OP_READ_REGISTER;
+    }
+    if (cmd[0] == (read | AS5047P_REG_ANGLECOM)) {
+        if (sensor->isAnglePipelined()) {
+            return OP_READ_ANGLE;
+        }
+        *frames = 2;
+        return cmd[1] == (read | AS5047P_REG_ANGLECOM) ? OP_READ_ANGLE : OP_SKIPPED;
+    }
+    return OP_SKIPPED;
+}
+
+// Run one call of the given frames; false if its result differs from the recording
+static bool runOp(replay_device *d, replay_op op, uint8_t frames){
+    bus_replay *r = d->replay;
+    const bus_trace_record *a = r->peek(0);
+    const bus_trace_record *b = r->peek(1);
+
+    switch (op) {
+        case OP_SYNC: {
+            d->counter->sync();
+            uint32_t expected = ((uint32_t)b->in[1] << 24) | ((uint32_t)b->in[2] << 16) |
+                                ((uint32_t)b->in[3] << 8) | b->in[4];
+            return d->counter->getCount() == (int32_t)expected;
+        }
+        case OP_RESET:
+            d->counter->reset();
+            return true;
+        case OP_CLEAR_STATUS:
+            d->counter->clearStatus();
+            return true;
+        case OP_READ_STATUS:
+            return d->counter->readStatus() == a->in[1];
+        case OP_RECONFIGURE:
+            d->counter->reconfigure(a->out[1], b->out[1]);
+            return true;
+        case OP_WRITE_MDR1:
+            if (a->out[1] & LS7366R_MDR1_COUNT_DISABLE) {
+                d->counter->disable();
+            } else {
+                d->counter->enable();
+            }
+            return true;
+        case OP_READ_SAMPLE: {
+            as5047p_sample sample;
+            uint16_t angle = word(b->in) & AS5047P_ANGLE_MASK;
+            return d->sensor->readSample(&sample) && sample.angle == angle;
+        }
+        case OP_READ_REGISTER: {
+            uint16_t address = word(a->out) & AS5047P_FRAME_DATA;
+            return d->sensor->readRegister(address) == (word(b->in) & AS5047P_FRAME_DATA);
+        }
+        case OP_READ_ANGLE: {
+            uint16_t angle;
+            d->sensor->readAngleRawPipelined(&angle);
+            return angle == (word(r->peek(frames - 1)->in) & AS5047P_ANGLE_MASK);
+        }
+        case OP_LISTEN_ANGLE:
+            return d->sensor->readAngleRaw() == (word(a->in) & AS5047P_ANGLE_MASK);
+        default:
+            // The sensor saw a frame its driver did not send
+            if (d->sensor) {
+                d->sensor->restartAngle();
+            }
+            r->skip();
+            return true;
+    }
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s trace.bin\n", argv[0]);
+        return 2;
+    }
+    FILE *in = fopen(argv[1], "rb");
+    if (!in) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 2;
+    }
+    uint32_t len = (uint32_t)fread(dump, 1, sizeof(dump), in);
+    fclose(in);
+
+    int32_t count = bus_trace_parse(dump, len, records, REPLAY_MAX_RECORDS);
+    if (count < 0) {
+        fprintf(stderr, "%s: not a bus trace\n", argv[1]);
+        return 2;
+    }
+
+    host_sim::reset();
+    host_arduino::reset();
+
+    // One replay device and driver per traced device
+    static replay_device devices[REPLAY_MAX_DEVICES];
+    int n_devices = 0;
+    int free_pin = HOST_SIM_PINS - 1;
+    for (int32_t i = 0; i < count; i++) {
+        bool known = false;
+        for (int k = 0; k < n_devices; k++) {
+            known = known || devices[k].device == records[i].device;
+        }
+        if (known) {
+            continue;
+        }
+        if (n_devices == REPLAY_MAX_DEVICES) {
+            fprintf(stderr, "more than %d devices\n", REPLAY_MAX_DEVICES);
+            return 2;
+        }
+        replay_device &d = devices[n_devices++];
+        d.device = records[i].device;
+        d.kind = records[i].kind;
+        d.counter = 0;
+        d.sensor = 0;
+        if ((d.kind & ~BUS_TRACE_NO_MOSI) == BUS_TRACE_LS7366R) {
+            d.replay = new bus_replay(records, count, d.device);
+            d.counter = new LS7366R_Single(d.device);
+            pinMode(d.device, OUTPUT);
+            digitalWrite(d.device, HIGH);
+        } else {
+            int miso = free_pin--, clk = free_pin--;
+            int mosi = (d.kind & BUS_TRACE_NO_MOSI) ? -1 : free_pin--;
+            d.replay = new bus_replay(records, count, d.device, miso, clk, mosi);
+            d.sensor = new as5047p_core<host_platform>(d.device, miso, clk,
+                                                       mosi < 0 ? host_platform::NO_PIN : mosi);
+        }
+    }
+
+    for (int32_t i = 0; i < count; i++) {
+        if (consumed[i]) {
+            continue;
+        }
+        replay_device *d = 0;
+        for (int k = 0; k < n_devices; k++) {
+            if (devices[k].device == records[i].device) {
+                d = &devices[k];
+            }
+        }
+
+        uint8_t frames;
+        replay_op op = d->counter ? inferCounter(d->replay, &frames) : inferSensor(d->replay, d->sensor, &frames);
+        if (op == OP_SKIPPED) {
+            frames = 1;
+        }
+
+        const bus_trace_record *last = d->replay->peek(frames - 1);
+        for (uint8_t f = 0; f < frames; f++) {
+            consumed[d->replay->peek(f) - records] = true;
+        }
+        op_stats &st = stats[op];
+        st.field_us += last->time_us + last->duration_us - records[i].time_us;
+
+        uint64_t bus_start = host_sim::nanos();
+        uint64_t start = bench_now_ns();
+        bool ok = runOp(d, op, frames);
+        st.host_ns += bench_now_ns() - start;
+        st.bus_ns += host_sim::nanos() - bus_start;
+        st.runs++;
+        if (!ok) {
+            st.wrong++;
+        }
+    }
+
+    printf("%d records, %d devices\n", count, n_devices);
+    printf("%-30s %7s %7s %10s %10s %10s\n", "call", "runs", "wrong", "host ns", "replay us", "field us");
+    uint32_t wrong = 0;
+    for (int op = 0; op < OP_COUNT; op++) {
+        op_stats &st = stats[op];
+        if (!st.runs) {
+            continue;
+        }
+        printf("%-30s %7u %7u %10.1f %10.1f %10.1f\n", op_names[op], st.runs, st.wrong,
+               (double)st.host_ns / st.runs, (double)st.bus_ns / 1000.0 / st.runs,
+               (double)st.field_us / st.runs);
+        wrong += st.wrong;
+    }
+
+    uint32_t frames = 0, mismatches = 0, missing = 0;
+    for (int k = 0; k < n_devices; k++) {
+        frames += devices[k].replay->getFrames();
+        mismatches += devices[k].replay->getMismatches();
+        missing += devices[k].replay->getMissing();
+    }
+    printf("frames replayed %u, MOSI mismatches %u, missing %u, wrong results %u\n",
+           frames, mismatches, missing, wrong);
+    return (mismatches || missing || wrong) ? 1 : 0;
+}